@@ -0,0 +1,1379 @@
+/*
+ * Behaviour checks against known answers and brute force references
+ * Includes voxelizer.c directly so internal routines can be checked too
+ */
+#include "../voxelizer.c"
+#ifdef _WIN32
+#include <direct.h>
+#define test_mkdir(path) _mkdir(path)
+#define test_rmdir(path) _rmdir(path)
+#else
+#define test_mkdir(path) mkdir((path), 0755)
+#define test_rmdir(path) rmdir(path)
+#endif
+
+
+static int failures = 0;
+
+
+#define VL_CHECK(cond) do { \
+	if (!(cond)) { \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		failures++; \
+	} \
+} while (0)
+
+
+/*
+ * Axis aligned box from origin to (sx, sy, sz), wound outwards
+ */
+static void test_box(VL_Vector3F * verts, VL_Size * faces, VL_Float sx, VL_Float sy, VL_Float sz) {
+	static const VL_Size quads[6][4] = {
+		{ 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 },
+	};
+	for (int i = 0; i < 8; i++) {
+		verts[i].x = (i & 4) ? sx : 0.0;
+		verts[i].y = (i & 2) ? sy : 0.0;
+		verts[i].z = (i & 1) ? sz : 0.0;
+	}
+	for (int q = 0; q < 6; q++) {
+		faces[q * 6 + 0] = quads[q][0]; faces[q * 6 + 1] = quads[q][1]; faces[q * 6 + 2] = quads[q][2];
+		faces[q * 6 + 3] = quads[q][0]; faces[q * 6 + 4] = quads[q][2]; faces[q * 6 + 5] = quads[q][3];
+	}
+}
+
+
+/*
+ * UV sphere of nu * (nv + 1) vertices and nu * nv * 2 faces, verts and faces should be freed manually
+ */
+static void test_sphere(VL_Vector3F ** verts, VL_Size * nverts, VL_Size ** faces, VL_Size * nfaces,
+	int nu, int nv, VL_Float r, VL_Float cx, VL_Float cy, VL_Float cz) {
+	const double pi = 3.14159265358979323846;
+	VL_Size k = 0;
+	*nverts = nu * (nv + 1);
+	*nfaces = nu * nv * 2;
+	*verts = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * (*nverts));
+	*faces = (VL_Size *)malloc(sizeof(VL_Size) * (*nfaces) * 3);
+	for (int j = 0; j <= nv; j++) {
+		for (int i = 0; i < nu; i++) {
+			double th = pi * j / nv, ph = 2.0 * pi * i / nu;
+			VL_Vector3F * p = *verts + j * nu + i;
+			p->x = cx + r * sin(th) * cos(ph);
+			p->y = cy + r * sin(th) * sin(ph);
+			p->z = cz + r * cos(th);
+		}
+	}
+	for (int j = 0; j < nv; j++) {
+		for (int i = 0; i < nu; i++) {
+			VL_Size a = j * nu + i, b = j * nu + (i + 1) % nu;
+			VL_Size c = (j + 1) * nu + i, d = (j + 1) * nu + (i + 1) % nu;
+			(*faces)[k++] = a; (*faces)[k++] = c; (*faces)[k++] = b;
+			(*faces)[k++] = b; (*faces)[k++] = c; (*faces)[k++] = d;
+		}
+	}
+}
+
+
+/*
+ * Grid of random voxels, each solid with probability density
+ */
+static bool test_random_grid(VL_VoxelGrid * grid, VL_Size cx, VL_Size cy, VL_Size cz, VL_Float ox, VL_Float oy, VL_Float oz, VL_Float vsize, double density) {
+	VL_VoxelHeader header;
+	header.origin.x = ox;
+	header.origin.y = oy;
+	header.origin.z = oz;
+	header.vsize = vsize;
+	header.cx = cx;
+	header.cy = cy;
+	header.cz = cz;
+	if (!vl_grid_alloc(grid, &header)) {
+		return false;
+	}
+	for (VL_Size z = 0; z < cz; z++) {
+		for (VL_Size y = 0; y < cy; y++) {
+			for (VL_Size x = 0; x < cx; x++) {
+				if (rand() < density * RAND_MAX) {
+					vl_grid_row(grid, y, z)[x / 64] |= (uint64_t)1 << (x % 64);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+
+/*
+ * Voxel of grid at signed coordinates, false outside of it
+ */
+static bool test_grid_at(const VL_VoxelGrid * grid, long long x, long long y, long long z) {
+	if ((x < 0) || (y < 0) || (z < 0)) {
+		return false;
+	}
+	return vl_grid_get(grid, (VL_Size)x, (VL_Size)y, (VL_Size)z);
+}
+
+
+static void test_vec3_cross() {
+	const VL_Vector3F x = { 1.0, 0.0, 0.0 }, y = { 0.0, 1.0, 0.0 };
+	const VL_Vector3F a = { 1.5, -2.0, 0.25 }, b = { -0.5, 3.0, 4.0 };
+	VL_Vector3F c;
+	VL_Float d;
+
+	vl_vec3_cross(&c, &x, &y);
+	VL_CHECK(c.x == 0.0 && c.y == 0.0 && c.z == 1.0);
+	// Cross product is perpendicular to both operands
+	vl_vec3_cross(&c, &a, &b);
+	VL_CHECK(c.x == -8.75 && c.y == -6.125 && c.z == 3.5);
+	vl_vec3_dot(&d, &c, &a);
+	VL_CHECK(d == 0.0);
+	vl_vec3_dot(&d, &c, &b);
+	VL_CHECK(d == 0.0);
+}
+
+
+/*
+ * Separating axis overlap of projected triangle and square of half size h
+ * around (px, py), positive when they overlap, negative when separated
+ */
+static double ref_square_tri_overlap(const VL_Vector3F * const p, double px, double py, double h) {
+	double overlap = 1e30;
+	for (int axis = 0; axis < 5; axis++) {
+		double nx, ny, len, lo = 1e30, hi = -1e30, c, r;
+		if (axis < 2) {
+			nx = axis == 0 ? 1.0 : 0.0;
+			ny = axis == 0 ? 0.0 : 1.0;
+		} else {
+			const VL_Vector3F * a = p + axis - 2, * b = p + (axis - 1) % 3;
+			nx = -(b->y - a->y);
+			ny = b->x - a->x;
+		}
+		len = sqrt(nx * nx + ny * ny);
+		nx /= len;
+		ny /= len;
+		for (int k = 0; k < 3; k++) {
+			double d = p[k].x * nx + p[k].y * ny;
+			lo = VL_MIN(lo, d);
+			hi = VL_MAX(hi, d);
+		}
+		c = px * nx + py * ny;
+		r = h * (fabs(nx) + fabs(ny));
+		overlap = VL_MIN(overlap, VL_MIN(hi - (c - r), (c + r) - lo));
+	}
+	return overlap;
+}
+
+
+static void test_proj_setup() {
+	const VL_Float vsize = 0.1;
+	VL_Vector3F v[3], p[3];
+	VL_Size f[3] = { 0, 1, 2 }, id = 0;
+	VL_MeshDesc mesh;
+	VL_ProjSetup setup;
+	long nhits = 0;
+
+	srand(11);
+	for (int t = 0; t < 500; t++) {
+		for (int k = 0; k < 3; k++) {
+			v[k].x = rand() / (VL_Float)RAND_MAX * 2.0 - 1.0;
+			v[k].y = rand() / (VL_Float)RAND_MAX * 2.0 - 1.0;
+			v[k].z = rand() / (VL_Float)RAND_MAX * 2.0 - 1.0;
+		}
+		vl_mesh_desc_native(&mesh, v, 3, f, 1);
+		for (int axis = VL_EProjectFront; axis <= VL_EProjectTop; axis++) {
+			VL_CHECK(vl_proj_setup_build(&setup, (VL_ProjectDirection)axis, &mesh, NULL, vsize));
+			// Edge-on triangles are covered by the segment path
+			if (setup.ntris == 1) {
+				for (int k = 0; k < 3; k++) {
+					vl_proj_vert(p + k, v + k, (VL_ProjectDirection)axis);
+				}
+				for (int i = 0; i < 30; i++) {
+					for (int j = 0; j < 30; j++) {
+						VL_Float px = -1.5 + i * vsize, py = -1.5 + j * vsize;
+						double overlap = ref_square_tri_overlap(p, px, py, vsize / 2.0);
+						bool hit = vl_proj_setup_hit(&setup, &id, 1, px, py);
+						// Touching within rounding may go either way
+						if (fabs(overlap) > 1e-5) {
+							VL_CHECK(hit == (overlap > 0.0));
+						}
+						nhits += hit;
+					}
+				}
+			}
+			vl_proj_setup_free(&setup);
+		}
+	}
+	VL_CHECK(nhits > 0);
+}
+
+
+static int vl_test_key_cmp(const void * a, const void * b) {
+	uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+	return (ka > kb) - (ka < kb);
+}
+
+
+static void test_morton() {
+	VL_Vector3F * verts, * points, p;
+	VL_Size * faces, nverts, nfaces, npoints, nkeys, x, y, z;
+	VL_VoxelHeader header;
+	uint64_t * keys;
+
+	VL_CHECK(vl_morton_encode(1, 0, 0) == 1);
+	VL_CHECK(vl_morton_encode(0, 1, 0) == 2);
+	VL_CHECK(vl_morton_encode(0, 0, 1) == 4);
+	VL_CHECK(vl_morton_encode(3, 0, 0) == 9);
+	VL_CHECK(vl_morton_encode(VL_MORTON_MAX_RES - 1, VL_MORTON_MAX_RES - 1, VL_MORTON_MAX_RES - 1) == 0x7fffffffffffffffULL);
+	srand(27);
+	for (int i = 0; i < 1000; i++) {
+		VL_Size ix = rand() % VL_MORTON_MAX_RES, iy = rand() % VL_MORTON_MAX_RES, iz = rand() % VL_MORTON_MAX_RES;
+		vl_morton_decode(&x, &y, &z, vl_morton_encode(ix, iy, iz));
+		VL_CHECK(x == ix && y == iy && z == iz);
+	}
+
+	// Keys are strictly ascending and cover the same voxels as the point cloud
+	test_sphere(&verts, &nverts, &faces, &nfaces, 24, 12, 1.0, 0.3, -0.2, 0.1);
+	keys = vl_morton_from_mesh(NULL, &nkeys, &header, verts, nverts, faces, nfaces, 0.1);
+	points = vl_point_cloud_from_mesh(NULL, &npoints, verts, nverts, faces, nfaces, 0.1);
+	VL_CHECK(keys != NULL && points != NULL);
+	VL_CHECK(nkeys == npoints && nkeys > 0);
+	for (VL_Size i = 1; i < nkeys; i++) {
+		VL_CHECK(keys[i - 1] < keys[i]);
+	}
+	for (VL_Size i = 0; i < npoints; i++) {
+		uint64_t key;
+		x = (VL_Size)floor((points[i].x - header.origin.x) / header.vsize);
+		y = (VL_Size)floor((points[i].y - header.origin.y) / header.vsize);
+		z = (VL_Size)floor((points[i].z - header.origin.z) / header.vsize);
+		key = vl_morton_encode(x, y, z);
+		VL_CHECK(bsearch(&key, keys, nkeys, sizeof(uint64_t), vl_test_key_cmp) != NULL);
+		vl_point_from_morton(&p, &header, key);
+		VL_CHECK(fabs(p.x - points[i].x) < 1e-4 && fabs(p.y - points[i].y) < 1e-4 && fabs(p.z - points[i].z) < 1e-4);
+	}
+	free(keys);
+	free(points);
+	free(verts);
+	free(faces);
+}
+
+
+static void test_grid_overflow() {
+	const VL_Vector3F vmin = { 0.0, 0.0, 0.0 }, vmax = { 100.0, 100.0, 100.0 };
+	VL_Vector3F verts[3] = { { 0.0, 0.0, 0.0 }, { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 1.0 } };
+	VL_Size faces[3] = { 0, 1, 2 }, cx, cy, cz, npoints;
+	VL_Plan plan;
+	VL_Vector3F * points;
+
+	vl_point_cloud_res_from_bbox(&cx, &cy, &cz, &vmin, &vmax, 0.125);
+	VL_CHECK(cx == 800 && cy == 800 && cz == 800);
+	// 10^24 voxels can not be indexed by VL_Size
+	vl_point_cloud_res_from_bbox(&cx, &cy, &cz, &vmin, &vmax, 1e-6);
+	VL_CHECK(cx == 0 && cy == 0 && cz == 0);
+	vl_point_cloud_res_from_bbox(&cx, &cy, &cz, &vmin, &vmax, (VL_Float)NAN);
+	VL_CHECK(cx == 0 && cy == 0 && cz == 0);
+	vl_point_cloud_res_from_mesh(&cx, &cy, &cz, NULL, NULL, verts, 3, 1e-9);
+	VL_CHECK(cx == 0 && cy == 0 && cz == 0);
+
+	VL_CHECK(!vl_plan_from_mesh(&plan, verts, 3, faces, 1, 1e-9));
+	VL_CHECK(plan.overflow);
+	VL_CHECK(vl_point_cloud_from_mesh(NULL, &npoints, verts, 3, faces, 1, 1e-9) == NULL);
+
+	// Non finite vertices are rejected before any dims are cast
+	verts[0].x = (VL_Float)NAN;
+	VL_CHECK(vl_point_cloud_from_mesh(NULL, &npoints, verts, 3, faces, 1, 0.1) == NULL);
+	verts[0].x = (VL_Float)INFINITY;
+	VL_CHECK(vl_point_cloud_from_mesh(NULL, &npoints, verts, 3, faces, 1, 0.1) == NULL);
+	// NaN past the first vertex is skipped by bbox and must not break tile binning
+	verts[0].x = 0.0;
+	verts[2].y = (VL_Float)NAN;
+	points = vl_point_cloud_from_mesh(NULL, &npoints, verts, 3, faces, 1, 0.1);
+	free(points);
+}
+
+
+static void test_svo() {
+	VL_Vector3F * verts;
+	VL_Size * faces, nverts, nfaces;
+	VL_VoxelGrid grid;
+	VL_Svo svo;
+
+	test_sphere(&verts, &nverts, &faces, &nfaces, 24, 12, 1.0, 0.3, -0.2, 0.1);
+	VL_CHECK(vl_grid_from_mesh(&grid, verts, nverts, faces, nfaces, 0.07));
+	VL_CHECK(vl_svo_from_mesh(&svo, verts, nverts, faces, nfaces, 0.07));
+	VL_CHECK(svo.header.cx == grid.header.cx && svo.header.cy == grid.header.cy && svo.header.cz == grid.header.cz);
+	VL_CHECK(((VL_Size)1 << svo.depth) >= VL_MAX(VL_MAX(grid.header.cx, grid.header.cy), grid.header.cz));
+
+	// Lookup matches grid everywhere, and is empty past grid up to the octree bound
+	for (VL_Size z = 0; z < ((VL_Size)1 << svo.depth); z++) {
+		for (VL_Size y = 0; y < ((VL_Size)1 << svo.depth); y++) {
+			for (VL_Size x = 0; x < ((VL_Size)1 << svo.depth); x++) {
+				bool in = (x < grid.header.cx) && (y < grid.header.cy) && (z < grid.header.cz);
+				VL_CHECK(vl_svo_lookup(&svo, x, y, z) == (in && vl_grid_get(&grid, x, y, z)));
+			}
+		}
+	}
+
+	// Rays along +x through voxel centers stop at the first solid voxel of their row
+	for (VL_Size z = 0; z < grid.header.cz; z++) {
+		for (VL_Size y = 0; y < grid.header.cy; y++) {
+			const VL_Vector3F dir = { 1.0, 0.0, 0.0 };
+			VL_Vector3F origin;
+			VL_Size x = 0;
+			VL_Float t = -1.0;
+			bool hit;
+			origin.x = grid.header.origin.x - 1.0;
+			origin.y = grid.header.origin.y + (y + 0.5) * grid.header.vsize;
+			origin.z = grid.header.origin.z + (z + 0.5) * grid.header.vsize;
+			while ((x < grid.header.cx) && !vl_grid_get(&grid, x, y, z)) {
+				x++;
+			}
+			hit = vl_svo_raycast(&t, &svo, &origin, &dir);
+			VL_CHECK(hit == (x < grid.header.cx));
+			if (hit) {
+				VL_CHECK(fabs(t - (1.0 + x * grid.header.vsize)) < 1e-4);
+			}
+		}
+	}
+	vl_svo_free(&svo);
+	vl_grid_free(&grid);
+	free(verts);
+	free(faces);
+}
+
+
+static void test_format_float() {
+	const double values[] = {
+		0.5e-6, -0.0, 0.0, 1e11, -1e11, 1e300, -1e300, 2.5e-6, 1.5, 0.1, -0.05, 123456.7890125,
+		9999999.9999995, 1e7, 12345678.25, 9e14, 2e15, DBL_MIN, DBL_MAX, INFINITY, -INFINITY, NAN,
+	};
+	char got[64], want[64];
+	char * end;
+
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		end = vl_format_float(got, values[i]);
+		*end = '\0';
+		snprintf(want, sizeof(want), fabs(values[i]) < 1e15 ? "%.6f" : "%.17g", values[i]);
+		VL_CHECK(strcmp(got, want) == 0);
+		VL_CHECK(end - got <= VL_FORMAT_FLOAT_MAX);
+	}
+	// Random magnitudes and exact halves of the last decimal
+	srand(30);
+	for (int i = 0; i < 200000; i++) {
+		double v = (rand() / (double)RAND_MAX - 0.5) * pow(10.0, rand() % 22 - 8);
+		if (i % 4 == 0) {
+			v = (rand() % 2000000 + 0.5) / 1e6 * ((i % 8) ? 1.0 : -1.0);
+		}
+		end = vl_format_float(got, v);
+		*end = '\0';
+		snprintf(want, sizeof(want), fabs(v) < 1e15 ? "%.6f" : "%.17g", v);
+		VL_CHECK(strcmp(got, want) == 0);
+	}
+}
+
+
+/*
+ * Write mesh of point cloud in format and read whole file back, result should be freed manually
+ */
+static unsigned char * test_write_read(size_t * nbytes, VL_MeshFormat format, const VL_Vector3F * points, VL_Size npoints, VL_Float vsize) {
+	FILE * f = tmpfile();
+	unsigned char * data = NULL;
+	long size;
+
+	*nbytes = 0;
+	if (NULL == f) {
+		return NULL;
+	}
+	if (vl_write_mesh_from_point_cloud(fileno(f), format, points, npoints, vsize) &&
+		(fseek(f, 0, SEEK_END) == 0) && ((size = ftell(f)) > 0) && (fseek(f, 0, SEEK_SET) == 0)) {
+		data = (unsigned char *)malloc((size_t)size + 1);
+		if (NULL != data) {
+			*nbytes = fread(data, 1, (size_t)size, f);
+			data[*nbytes] = '\0';
+		}
+	}
+	fclose(f);
+	return data;
+}
+
+
+static float test_f32le(const unsigned char * p) {
+	uint32_t bits = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+	float v;
+	memcpy(&v, &bits, sizeof(v));
+	return v;
+}
+
+
+static uint32_t test_u32le(const unsigned char * p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+static void test_write_mesh() {
+	const VL_Vector3F points[3] = { { 0.05, 0.05, 0.05 }, { -1.25, 3.5, 1e-7 }, { 123.45, -0.15, 7.0 } };
+	const VL_Size npoints = 3;
+	const VL_Float vsize = 0.1;
+	VL_Vector3F * verts;
+	VL_Size * faces, nverts, nfaces;
+	unsigned char * data, * p;
+	size_t nbytes;
+
+	// Same corners as vl_mesh_from_point_cloud, triangles rewound outwards as vl_cube_tris
+	vl_mesh_from_point_cloud(&verts, &nverts, &faces, &nfaces, points, npoints, vsize);
+	VL_CHECK(nverts == npoints * 8 && nfaces == npoints * 12);
+	for (VL_Size i = 0; i < nfaces; i++) {
+		for (int j = 0; j < 3; j++) {
+			faces[i * 3 + j] = i / 12 * 8 + vl_cube_tris[i % 12][j];
+		}
+	}
+
+	// OBJ, vertices to 6 decimals and 1 based faces
+	data = test_write_read(&nbytes, VL_EFormatObj, points, npoints, vsize);
+	VL_CHECK(data != NULL);
+	if (data) {
+		char * line = strtok((char *)data, "\n");
+		VL_Size iv = 0, jf = 0;
+		while (line) {
+			if (line[0] == 'v' && iv < nverts) {
+				double x, y, z;
+				VL_CHECK(sscanf(line, "v %lf %lf %lf", &x, &y, &z) == 3);
+				VL_CHECK(fabs(x - verts[iv].x) <= 5e-7 && fabs(y - verts[iv].y) <= 5e-7 && fabs(z - verts[iv].z) <= 5e-7);
+				iv++;
+			} else if (line[0] == 'f' && jf < nfaces) {
+				unsigned long a, b, c;
+				VL_CHECK(sscanf(line, "f %lu %lu %lu", &a, &b, &c) == 3);
+				VL_CHECK(a == faces[jf * 3] + 1 && b == faces[jf * 3 + 1] + 1 && c == faces[jf * 3 + 2] + 1);
+				jf++;
+			}
+			line = strtok(NULL, "\n");
+		}
+		VL_CHECK(iv == nverts && jf == nfaces);
+		free(data);
+	}
+
+	// PLY, header then float vertices and uchar uint faces
+	data = test_write_read(&nbytes, VL_EFormatPly, points, npoints, vsize);
+	VL_CHECK(data != NULL);
+	if (data) {
+		unsigned long nv = 0, nf = 0;
+		p = (unsigned char *)strstr((char *)data, "end_header\n");
+		VL_CHECK(sscanf(strstr((char *)data, "element vertex"), "element vertex %lu", &nv) == 1 && nv == nverts);
+		VL_CHECK(sscanf(strstr((char *)data, "element face"), "element face %lu", &nf) == 1 && nf == nfaces);
+		VL_CHECK(p != NULL);
+		p += strlen("end_header\n");
+		VL_CHECK((size_t)(p - data) + nverts * 12 + nfaces * 13 == nbytes);
+		for (VL_Size i = 0; i < nverts; i++, p += 12) {
+			VL_CHECK(test_f32le(p) == (float)verts[i].x && test_f32le(p + 4) == (float)verts[i].y && test_f32le(p + 8) == (float)verts[i].z);
+		}
+		for (VL_Size i = 0; i < nfaces; i++, p += 13) {
+			VL_CHECK(p[0] == 3);
+			VL_CHECK(test_u32le(p + 1) == faces[i * 3] && test_u32le(p + 5) == faces[i * 3 + 1] && test_u32le(p + 9) == faces[i * 3 + 2]);
+		}
+		free(data);
+	}
+
+	// STL, 80 byte header, count and 50 bytes per triangle
+	data = test_write_read(&nbytes, VL_EFormatStl, points, npoints, vsize);
+	VL_CHECK(data != NULL);
+	if (data) {
+		VL_CHECK(nbytes == 84 + nfaces * 50);
+		VL_CHECK(test_u32le(data + 80) == nfaces);
+		p = data + 84;
+		for (VL_Size i = 0; i < nfaces && nbytes == 84 + nfaces * 50; i++, p += 50) {
+			const VL_Vector3F * c = points + i / 12;
+			VL_Vector3F n, e1, e2, cross;
+			VL_Float d;
+			for (int j = 0; j < 3; j++) {
+				const VL_Vector3F * v = verts + faces[i * 3 + j];
+				const unsigned char * q = p + 12 + j * 12;
+				VL_CHECK(test_f32le(q) == (float)v->x && test_f32le(q + 4) == (float)v->y && test_f32le(q + 8) == (float)v->z);
+			}
+			// Normal points away from voxel center and agrees with counter clockwise winding
+			n.x = test_f32le(p); n.y = test_f32le(p + 4); n.z = test_f32le(p + 8);
+			vl_vec3_sub(&e1, verts + faces[i * 3 + 1], verts + faces[i * 3]);
+			vl_vec3_sub(&e2, verts + faces[i * 3 + 2], verts + faces[i * 3]);
+			vl_vec3_cross(&cross, &e1, &e2);
+			vl_vec3_dot(&d, &cross, &n);
+			VL_CHECK(d > 0.0);
+			vl_vec3_sub(&e1, verts + faces[i * 3], c);
+			vl_vec3_dot(&d, &e1, &n);
+			VL_CHECK(d > 0.0);
+		}
+		free(data);
+	}
+	free(verts);
+	free(faces);
+}
+
+
+/*
+ * Run every _desc entry point on mesh, returns how many of them succeeded
+ */
+static int test_desc_entry_points(const VL_MeshDesc * const mesh) {
+	VL_Vector3F * points;
+	uint64_t * keys;
+	VL_Size n;
+	VL_VoxelHeader header;
+	VL_Plan plan;
+	VL_Svo svo;
+	VL_VoxelGrid grid;
+	VL_MassProperties props;
+	VL_Mesh prepared;
+	VL_CachedPointCloud cached;
+	int nok = 0;
+
+	points = vl_point_cloud_from_mesh_desc(NULL, &n, mesh, 0.25);
+	nok += points != NULL;
+	free(points);
+	nok += vl_volume_from_mesh_desc(mesh, 0.25) > 0.0;
+	keys = vl_morton_from_mesh_desc(NULL, &n, &header, mesh, 0.25);
+	nok += keys != NULL;
+	free(keys);
+	nok += vl_plan_from_mesh_desc(&plan, mesh, 0.25);
+	nok += vl_plan_vsize_from_budget_desc(NULL, mesh, 1e9, 1e12) > 0.0;
+	if (vl_svo_from_mesh_desc(&svo, mesh, 0.25)) {
+		vl_svo_free(&svo);
+		nok++;
+	}
+	if (vl_grid_from_mesh_desc(&grid, mesh, 0.25)) {
+		vl_grid_free(&grid);
+		nok++;
+	}
+	nok += vl_mass_properties_from_mesh_desc(&props, mesh, 0.25);
+	if (vl_mesh_prepare_desc(&prepared, mesh, 0.0)) {
+		vl_mesh_free(&prepared);
+		nok++;
+	}
+	if (vl_cached_point_cloud_from_mesh_desc(&cached, NULL, 0.0, mesh, 0.25)) {
+		vl_cached_point_cloud_free(&cached);
+		nok++;
+	}
+	nok += vl_cached_volume_from_mesh_desc(NULL, 0.0, mesh, 0.25) > 0.0;
+	return nok;
+}
+
+
+static void test_mesh_desc_indices() {
+	VL_Vector3F verts[8];
+	VL_Size faces[36];
+	uint16_t faces16[36];
+	uint64_t faces64[36];
+	VL_MeshDesc mesh;
+
+	test_box(verts, faces, 1.0, 2.0, 3.0);
+	for (int i = 0; i < 36; i++) {
+		faces16[i] = (uint16_t)faces[i];
+		faces64[i] = faces[i];
+	}
+	mesh.verts       = verts;
+	mesh.vert_type   = sizeof(VL_Float) == sizeof(float) ? VL_EComponentFloat32 : VL_EComponentFloat64;
+	mesh.vert_stride = sizeof(VL_Vector3F);
+	mesh.nverts      = 8;
+	mesh.nfaces      = 12;
+
+	mesh.faces = faces16;
+	mesh.face_type = VL_EIndexU16;
+	VL_CHECK(test_desc_entry_points(&mesh) == 11);
+	faces16[35] = 8;
+	VL_CHECK(test_desc_entry_points(&mesh) == 0);
+
+	mesh.faces = faces64;
+	mesh.face_type = VL_EIndexU64;
+	VL_CHECK(test_desc_entry_points(&mesh) == 11);
+	// Would wrap to vertex 1 if narrowed to 32 bits before the check
+	faces64[7] = ((uint64_t)1 << 32) + 1;
+	VL_CHECK(test_desc_entry_points(&mesh) == 0);
+	faces64[7] = faces[7];
+	mesh.nverts = 7;
+	VL_CHECK(test_desc_entry_points(&mesh) == 0);
+}
+
+
+static void test_grid_boolean() {
+	const VL_BoolOp ops[4] = { VL_EBoolUnion, VL_EBoolIntersection, VL_EBoolDifference, VL_EBoolXor };
+	VL_VoxelGrid a, b, out;
+	VL_Vector3F * points;
+	VL_Size count, npoints;
+
+	srand(32);
+	for (int t = 0; t < 40; t++) {
+		const VL_Float vsize = 0.25;
+		// Origin of b is off the lattice of a by less than half a voxel
+		VL_CHECK(test_random_grid(&a, rand() % 150 + 1, rand() % 9 + 1, rand() % 9 + 1, 1.0, -2.0, 0.5, vsize, 0.4));
+		VL_CHECK(test_random_grid(&b, rand() % 150 + 1, rand() % 9 + 1, rand() % 9 + 1,
+				1.0 + (rand() % 200 - 100 + 0.3) * vsize, -2.0 + (rand() % 12 - 6 - 0.2) * vsize, 0.5 + (rand() % 12 - 6) * vsize,
+				vsize, 0.4));
+		for (int o = 0; o < 4; o++) {
+			long long off[3], lo[3], ref = 0;
+			VL_CHECK(vl_grid_boolean(&out, &a, &b, ops[o]));
+			VL_CHECK(vl_grid_boolean_count(&count, &a, &b, ops[o]));
+			off[0] = (long long)floor((b.header.origin.x - a.header.origin.x) / vsize + 0.5);
+			off[1] = (long long)floor((b.header.origin.y - a.header.origin.y) / vsize + 0.5);
+			off[2] = (long long)floor((b.header.origin.z - a.header.origin.z) / vsize + 0.5);
+			lo[0] = (long long)floor((out.header.origin.x - a.header.origin.x) / vsize + 0.5);
+			lo[1] = (long long)floor((out.header.origin.y - a.header.origin.y) / vsize + 0.5);
+			lo[2] = (long long)floor((out.header.origin.z - a.header.origin.z) / vsize + 0.5);
+			if (ops[o] == VL_EBoolDifference) {
+				VL_CHECK(out.header.cx == a.header.cx && out.header.cy == a.header.cy && out.header.cz == a.header.cz);
+			}
+			for (long long z = -1; z <= (long long)out.header.cz; z++) {
+				for (long long y = -1; y <= (long long)out.header.cy; y++) {
+					for (long long x = -1; x <= (long long)out.header.cx; x++) {
+						bool va = test_grid_at(&a, lo[0] + x, lo[1] + y, lo[2] + z);
+						bool vb = test_grid_at(&b, lo[0] + x - off[0], lo[1] + y - off[1], lo[2] + z - off[2]);
+						bool inside = (x >= 0) && (y >= 0) && (z >= 0) &&
+							(x < (long long)out.header.cx) && (y < (long long)out.header.cy) && (z < (long long)out.header.cz);
+						bool want = ops[o] == VL_EBoolUnion ? (va || vb) :
+									ops[o] == VL_EBoolIntersection ? (va && vb) :
+									ops[o] == VL_EBoolDifference ? (va && !vb) : (va != vb);
+						// Frame is exact, no solid voxel of the result lies outside of it
+						if (inside) {
+							VL_CHECK(test_grid_at(&out, x, y, z) == want);
+							ref += want;
+						} else {
+							VL_CHECK(!want);
+						}
+					}
+				}
+			}
+			VL_CHECK(count == (VL_Size)ref);
+			VL_CHECK(vl_grid_count(&out) == (VL_Size)ref);
+			vl_grid_free(&out);
+		}
+		vl_grid_free(&a);
+		vl_grid_free(&b);
+	}
+
+	// Empty result still gives a point cloud pointer
+	VL_CHECK(test_random_grid(&a, 70, 3, 2, 0.0, 0.0, 0.0, 0.5, 0.5));
+	VL_CHECK(vl_grid_boolean(&out, &a, &a, VL_EBoolDifference));
+	points = vl_point_cloud_from_grid(NULL, &npoints, &out);
+	VL_CHECK(points != NULL && npoints == 0);
+	free(points);
+	points = vl_point_cloud_from_grid(NULL, &npoints, &a);
+	VL_CHECK(points != NULL && npoints == vl_grid_count(&a));
+	for (VL_Size i = 0; i < npoints; i++) {
+		VL_CHECK(vl_grid_get(&a, (VL_Size)(points[i].x / 0.5), (VL_Size)(points[i].y / 0.5), (VL_Size)(points[i].z / 0.5)));
+	}
+	free(points);
+	vl_grid_free(&out);
+
+	// Voxel sizes must agree
+	VL_CHECK(test_random_grid(&b, 5, 5, 5, 0.0, 0.0, 0.0, 0.25, 0.5));
+	count = 1;
+	VL_CHECK(!vl_grid_boolean_count(&count, &a, &b, VL_EBoolUnion) && count == 0);
+	VL_CHECK(!vl_grid_boolean(&out, &a, &b, VL_EBoolUnion));
+	vl_grid_free(&a);
+	vl_grid_free(&b);
+}
+
+
+static void test_mass_properties() {
+	VL_Vector3F box_verts[8], * verts;
+	VL_Size box_faces[36], * faces, nverts, nfaces;
+	VL_MassProperties props;
+	VL_VoxelGrid grid;
+	double n = 0.0, c[3] = { 0.0, 0.0, 0.0 }, inertia[3][3];
+
+	// Unit cube, 8 voxels per axis all solid
+	test_box(box_verts, box_faces, 1.0, 1.0, 1.0);
+	VL_CHECK(vl_mass_properties_from_mesh(&props, box_verts, 8, box_faces, 12, 0.125));
+	VL_CHECK(props.nvoxels == 512);
+	VL_CHECK(fabs(props.volume - 1.0) < 1e-6);
+	VL_CHECK(fabs(props.centroid.x - 0.5) < 1e-6 && fabs(props.centroid.y - 0.5) < 1e-6 && fabs(props.centroid.z - 0.5) < 1e-6);
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			VL_CHECK(fabs(props.inertia[i][j] - (i == j ? 1.0 / 6.0 : 0.0)) < 1e-6);
+		}
+	}
+	VL_CHECK(fabs(vl_volume_from_mesh(box_verts, 8, box_faces, 12, 0.125) - 1.0) < 1e-6);
+
+	// Off center sphere against a sum over solid voxels of the same grid
+	test_sphere(&verts, &nverts, &faces, &nfaces, 24, 12, 1.0, 0.3, -0.2, 0.1);
+	VL_CHECK(vl_mass_properties_from_mesh(&props, verts, nverts, faces, nfaces, 0.1));
+	VL_CHECK(vl_grid_from_mesh(&grid, verts, nverts, faces, nfaces, 0.1));
+	memset(inertia, 0, sizeof(inertia));
+	for (int pass = 0; pass < 2; pass++) {
+		for (VL_Size z = 0; z < grid.header.cz; z++) {
+			for (VL_Size y = 0; y < grid.header.cy; y++) {
+				for (VL_Size x = 0; x < grid.header.cx; x++) {
+					double p[3];
+					if (!vl_grid_get(&grid, x, y, z)) {
+						continue;
+					}
+					p[0] = grid.header.origin.x + (x + 0.5) * grid.header.vsize;
+					p[1] = grid.header.origin.y + (y + 0.5) * grid.header.vsize;
+					p[2] = grid.header.origin.z + (z + 0.5) * grid.header.vsize;
+					if (pass == 0) {
+						n += 1.0;
+						for (int i = 0; i < 3; i++) {
+							c[i] += p[i];
+						}
+						continue;
+					}
+					for (int i = 0; i < 3; i++) {
+						for (int j = 0; j < 3; j++) {
+							double d2 = 0.0;
+							for (int k = 0; k < 3; k++) {
+								d2 += (p[k] - c[k]) * (p[k] - c[k]);
+							}
+							inertia[i][j] += (i == j ? d2 : 0.0) - (p[i] - c[i]) * (p[j] - c[j]);
+						}
+					}
+				}
+			}
+		}
+		if (pass == 0) {
+			for (int i = 0; i < 3; i++) {
+				c[i] /= n;
+			}
+		}
+	}
+	VL_CHECK(props.nvoxels == (VL_Size)n && props.nvoxels == vl_grid_count(&grid));
+	VL_CHECK(fabs(props.volume - n * 1e-3) < 1e-6);
+	VL_CHECK(fabs(props.centroid.x - c[0]) < 1e-5 && fabs(props.centroid.y - c[1]) < 1e-5 && fabs(props.centroid.z - c[2]) < 1e-5);
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			// Point masses plus each voxel's own cube inertia, vsize^2 / 6 on the diagonal
+			double want = (inertia[i][j] + (i == j ? n / 6.0 * 0.01 : 0.0)) * 1e-3;
+			VL_CHECK(fabs(props.inertia[i][j] - want) < 1e-5 * VL_MAX(fabs(want), 1.0));
+		}
+	}
+	vl_grid_free(&grid);
+	free(verts);
+	free(faces);
+}
+
+
+static void test_mesh_prepare() {
+	VL_Vector3F box_verts[8], verts[24];
+	VL_Size box_faces[36], faces[36 * 3 + 6];
+	VL_Mesh mesh;
+	VL_MassProperties props;
+	VL_Size nfaces = 0;
+	bool used[8] = { false };
+
+	// Every corner three times within 1e-5, every face three times with its corners rotated or reversed
+	test_box(box_verts, box_faces, 1.0, 1.0, 1.0);
+	for (int copy = 0; copy < 3; copy++) {
+		for (int i = 0; i < 8; i++) {
+			verts[copy * 8 + i] = box_verts[i];
+			verts[copy * 8 + i].x += copy * 3e-6;
+			verts[copy * 8 + i].z -= copy * 4e-6;
+		}
+	}
+	for (int copy = 0; copy < 3; copy++) {
+		for (int f = 0; f < 12; f++) {
+			const VL_Size * t = box_faces + f * 3;
+			VL_Size * u = faces + nfaces++ * 3;
+			u[0] = t[copy % 3] + 8 * ((f + copy) % 3);
+			u[1] = t[(copy + 1) % 3] + 8 * copy;
+			u[2] = t[(copy + 2) % 3] + 8 * ((f + 2 * copy) % 3);
+			if (copy == 2) {
+				VL_Size temp = u[1]; u[1] = u[2]; u[2] = temp;
+			}
+		}
+	}
+	// Degenerated faces, repeated index and collinear corners
+	faces[nfaces * 3] = 0; faces[nfaces * 3 + 1] = 8; faces[nfaces * 3 + 2] = 1; nfaces++;
+	faces[nfaces * 3] = 0; faces[nfaces * 3 + 1] = 1; faces[nfaces * 3 + 2] = 9; nfaces++;
+
+	VL_CHECK(vl_mesh_prepare(&mesh, verts, 24, faces, nfaces, 1e-4));
+	VL_CHECK(mesh.nverts == 8);
+	// Identity of a face is its index set, so reversed copies are dropped as well
+	VL_CHECK(mesh.nfaces == 12);
+	for (VL_Size f = 0; f < mesh.nfaces * 3; f++) {
+		used[mesh.faces[f]] = true;
+	}
+	for (int i = 0; i < 8; i++) {
+		VL_CHECK(used[i]);
+	}
+	VL_CHECK(vl_mass_properties_from_mesh(&props, mesh.verts, mesh.nverts, mesh.faces, mesh.nfaces, 0.125));
+	VL_CHECK(props.nvoxels == 512);
+	vl_mesh_free(&mesh);
+
+	// Below tol vertices weld, above it they stay apart
+	VL_CHECK(vl_mesh_prepare(&mesh, verts, 24, faces, nfaces, 1e-6));
+	VL_CHECK(mesh.nverts == 24);
+	vl_mesh_free(&mesh);
+
+	// Tolerance far below 1 / 2^21 of extent still welds only within tol
+	for (int i = 0; i < 24; i++) {
+		verts[i].x *= 1e6;
+		verts[i].y *= 1e6;
+		verts[i].z *= 1e6;
+	}
+	VL_CHECK(vl_mesh_prepare(&mesh, verts, 24, faces, nfaces, 1e-3));
+	VL_CHECK(mesh.nverts == 24);
+	vl_mesh_free(&mesh);
+	VL_CHECK(vl_mesh_prepare(&mesh, verts, 24, faces, nfaces, 10.0));
+	VL_CHECK(mesh.nverts == 8 && mesh.nfaces == 12);
+	vl_mesh_free(&mesh);
+}
+
+
+/*
+ * Pixels where tile tracing of projection masks disagrees with testing every primitive
+ */
+static long test_proj_trace_mismatches(const VL_MeshDesc * const mesh, const VL_Float vsize) {
+	VL_ProjMasks masks;
+	VL_ProjSetup setup;
+	VL_Size * ids;
+	long nbad = 0;
+
+	if (!vl_proj_masks_from_mesh(&masks, mesh, vsize)) {
+		return -1;
+	}
+	for (int axis = VL_EProjectFront; axis <= VL_EProjectTop; axis++) {
+		// Same planes as vl_proj_masks_from_mesh, front (x, z), left (-y, z) and top (x, y)
+		VL_Size nu = axis == VL_EProjectLeft ? masks.cy : masks.cx;
+		VL_Size nv = axis == VL_EProjectTop ? masks.cy : masks.cz;
+		VL_Float u0 = axis == VL_EProjectLeft ? -masks.vmin.y : masks.vmin.x;
+		VL_Float du = axis == VL_EProjectLeft ? -vsize : vsize;
+		VL_Float v0 = axis == VL_EProjectTop ? masks.vmin.y : masks.vmin.z;
+		const bool * mask = axis == VL_EProjectFront ? masks.front : axis == VL_EProjectLeft ? masks.left : masks.top;
+
+		if (!vl_proj_setup_build(&setup, (VL_ProjectDirection)axis, mesh, NULL, vsize)) {
+			vl_proj_masks_free(&masks);
+			return -1;
+		}
+		ids = (VL_Size *)malloc(sizeof(VL_Size) * (setup.ntris + setup.nsegs + 1));
+		for (VL_Size i = 0; i < setup.ntris + setup.nsegs; i++) {
+			ids[i] = i;
+		}
+		for (VL_Size y = 0; y < nv; y++) {
+			for (VL_Size x = 0; x < nu; x++) {
+				VL_Float px = u0 + x * du, py = v0 + y * vsize;
+				if (vl_proj_setup_hit(&setup, ids, setup.ntris + setup.nsegs, px, py) != mask[y * nu + x]) {
+					nbad++;
+				}
+			}
+		}
+		free(ids);
+		vl_proj_setup_free(&setup);
+	}
+	vl_proj_masks_free(&masks);
+	return nbad;
+}
+
+
+static void test_proj_trace() {
+	VL_Vector3F * verts, tri[3] = { { 1.0, 1.0, -1.0 }, { -1.0, -1.0, -1.0 }, { 0.0, 0.0, 0.0 } };
+	VL_Size * faces, nverts, nfaces, tri_faces[3] = { 0, 1, 2 };
+	VL_MeshDesc mesh;
+	VL_PlanStats stats;
+	VL_Plan plan;
+
+	// Closed mesh, several tiles per axis with silhouettes crossing them
+	test_sphere(&verts, &nverts, &faces, &nfaces, 48, 24, 1.0, 0.1, 0.2, 0.3);
+	vl_mesh_desc_native(&mesh, verts, nverts, faces, nfaces);
+	VL_CHECK(test_proj_trace_mismatches(&mesh, 0.01) == 0);
+	VL_CHECK(test_proj_trace_mismatches(&mesh, 0.037) == 0);
+	free(verts);
+	free(faces);
+
+	// Faces a couple of voxels wide, tiles inside the outline are covered by their union only
+	test_sphere(&verts, &nverts, &faces, &nfaces, 96, 48, 1.0, -0.2, 0.1, 0.3);
+	vl_mesh_desc_native(&mesh, verts, nverts, faces, nfaces);
+	VL_CHECK(test_proj_trace_mismatches(&mesh, 0.03) == 0);
+	free(verts);
+	free(faces);
+
+	// Random soup, vertices past the first corner share its z every seventh time so some faces are edge-on
+	srand(3);
+	nverts = 300 * 3;
+	verts = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * nverts);
+	faces = (VL_Size *)malloc(sizeof(VL_Size) * nverts);
+	for (VL_Size i = 0; i < nverts; i++) {
+		verts[i].x = rand() % 1000 / 500.0;
+		verts[i].y = rand() % 1000 / 500.0;
+		verts[i].z = (i % 7 == 0) && (i % 3 != 0) ? verts[i - i % 3].z : rand() % 1000 / 500.0;
+		faces[i] = i;
+	}
+	vl_mesh_desc_native(&mesh, verts, nverts, faces, nverts / 3);
+	VL_CHECK(test_proj_trace_mismatches(&mesh, 0.013) == 0);
+	free(verts);
+	free(faces);
+
+	// Single triangle spanning the bbox diagonal
+	vl_mesh_desc_native(&mesh, tri, 3, tri_faces, 1);
+	VL_CHECK(test_proj_trace_mismatches(&mesh, 0.1) == 0);
+
+	// Bins that would not fit VL_Size are rejected by planning
+	VL_CHECK(vl_plan_stats_from_mesh(&stats, &mesh));
+	VL_CHECK(vl_plan_from_stats(&plan, &stats, 0.1) && !plan.overflow);
+	stats.proj_area = 1e30;
+	VL_CHECK(!vl_plan_from_stats(&plan, &stats, 0.1) && plan.overflow);
+}
+
+
+static void test_proj_trace_tiles() {
+	const VL_Float vsize = 0.005;
+	VL_Vector3F * verts, vmin, vmax;
+	VL_Size * faces, * partners, nverts, nfaces, cx, cy, cz, ntotal = 0;
+	VL_MeshDesc mesh;
+	VL_ProjSetup setup;
+	VL_PlanStats stats;
+	double nestimate;
+
+	// Faces are about ten voxels wide, so no single one covers a tile
+	test_sphere(&verts, &nverts, &faces, &nfaces, 128, 64, 1.0, 0.1, 0.2, 0.3);
+	vl_mesh_desc_native(&mesh, verts, nverts, faces, nfaces);
+	vl_mesh_desc_bbox(&vmin, &vmax, &mesh);
+	vl_point_cloud_res_from_bbox(&cx, &cy, &cz, &vmin, &vmax, vsize);
+	VL_CHECK(vl_mesh_desc_edge_partners(&partners, &mesh));
+	for (int axis = VL_EProjectFront; axis <= VL_EProjectTop; axis++) {
+		VL_Size nu = axis == VL_EProjectLeft ? cy : cx;
+		VL_Size nv = axis == VL_EProjectTop ? cy : cz;
+		VL_Size ntiles = ((nu + VL_TRACE_TILE - 1) / VL_TRACE_TILE) * ((nv + VL_TRACE_TILE - 1) / VL_TRACE_TILE);
+		VL_Size nrefined = ntiles, nfull = 0;
+		bool * buff = (bool *)malloc(sizeof(bool) * nu * nv);
+
+		VL_CHECK(vl_proj_setup_build(&setup, (VL_ProjectDirection)axis, &mesh, partners, vsize));
+		VL_CHECK(vl_proj_setup_trace(&setup, buff, nu, nv, axis == VL_EProjectLeft ? -vmin.y : vmin.x,
+									 axis == VL_EProjectLeft ? -vsize : vsize,
+									 axis == VL_EProjectTop ? vmin.y : vmin.z, vsize, &nrefined));
+		// Only edges along the rim and the poles are outline
+		VL_CHECK(setup.nedges * 8 < nfaces);
+		for (VL_Size t = 0; t < ntiles; t++) {
+			VL_Size ub = t % ((nu + VL_TRACE_TILE - 1) / VL_TRACE_TILE) * VL_TRACE_TILE;
+			VL_Size vb = t / ((nu + VL_TRACE_TILE - 1) / VL_TRACE_TILE) * VL_TRACE_TILE;
+			bool solid = true;
+			for (VL_Size v = vb; v < VL_MIN(vb + VL_TRACE_TILE, nv); v++) {
+				for (VL_Size u = ub; u < VL_MIN(ub + VL_TRACE_TILE, nu); u++) {
+					solid = solid && buff[v * nu + u];
+				}
+			}
+			nfull += solid;
+		}
+		// Disk of radius 12.5 tiles holds about 490 tiles and its rim crosses about 100
+		VL_CHECK(nfull > 400);
+		VL_CHECK(nrefined < 160);
+		ntotal += nrefined;
+		vl_proj_setup_free(&setup);
+		free(buff);
+	}
+	free(partners);
+
+	// Planning charges outline length, which bounds refined tiles, zero area faces fanning around poles inflate it
+	VL_CHECK(vl_plan_stats_from_mesh(&stats, &mesh));
+	nestimate = ceil(stats.outline_length / (vsize * VL_TRACE_TILE));
+	VL_CHECK(ntotal <= nestimate && nestimate < ntotal * 4.0);
+	free(verts);
+	free(faces);
+}
+
+/*
+ * Whether file of path exists
+ */
+static bool test_exists(const char * path) {
+	struct stat st;
+	return stat(path, &st) == 0;
+}
+
+
+static void test_cache() {
+	const char * dir = "vl_test_cache";
+	const VL_Float vsize = 0.05;
+	VL_Vector3F * verts, * points;
+	VL_Size * faces, nverts, nfaces, npoints;
+	VL_CachedPointCloud miss, hit;
+	VL_CacheFileHeader header;
+	VL_MeshDesc mesh;
+	VL_Float volume;
+	uint64_t key, check;
+	char * path, * stale, * fresh;
+	FILE * file;
+
+	test_mkdir(dir);
+	vl_cache_evict(dir, 0.5);
+	test_sphere(&verts, &nverts, &faces, &nfaces, 24, 12, 1.0, 0.3, -0.2, 0.1);
+	vl_mesh_desc_native(&mesh, verts, nverts, faces, nfaces);
+	points = vl_point_cloud_from_mesh(NULL, &npoints, verts, nverts, faces, nfaces, vsize);
+	VL_CHECK(points && npoints > 0);
+	VL_CHECK(vl_cache_key(&key, &check, &mesh, vsize, VL_ECacheKindPointCloud));
+	path = vl_cache_path(dir, key, ".vlc");
+
+	// Miss voxelizes on heap and publishes, hit maps the same points
+	VL_CHECK(vl_cached_point_cloud_from_mesh(&miss, dir, 0.0, verts, nverts, faces, nfaces, vsize));
+	VL_CHECK(NULL == miss.map && miss.npoints == npoints);
+	VL_CHECK(test_exists(path));
+	VL_CHECK(vl_cached_point_cloud_from_mesh(&hit, dir, 0.0, verts, nverts, faces, nfaces, vsize));
+	VL_CHECK(NULL != hit.map && hit.npoints == npoints);
+	if (miss.points && hit.points && (miss.npoints == npoints) && (hit.npoints == npoints)) {
+		VL_CHECK(memcmp(miss.points, points, sizeof(VL_Vector3F) * npoints) == 0);
+		VL_CHECK(memcmp(hit.points, points, sizeof(VL_Vector3F) * npoints) == 0);
+	}
+	vl_cached_point_cloud_free(&hit);
+	vl_cached_point_cloud_free(&miss);
+
+	// Entry whose second hash differs is a collision of file name, it misses and gets replaced
+	file = fopen(path, "r+b");
+	VL_CHECK(NULL != file);
+	if (file) {
+		VL_CHECK(fread(&header, sizeof(header), 1, file) == 1);
+		header.check ^= 1;
+		fseek(file, 0, SEEK_SET);
+		VL_CHECK(fwrite(&header, sizeof(header), 1, file) == 1);
+		fclose(file);
+	}
+	VL_CHECK(vl_cached_point_cloud_from_mesh(&miss, dir, 0.0, verts, nverts, faces, nfaces, vsize));
+	VL_CHECK(NULL == miss.map && miss.npoints == npoints);
+	vl_cached_point_cloud_free(&miss);
+	VL_CHECK(vl_cached_point_cloud_from_mesh(&hit, dir, 0.0, verts, nverts, faces, nfaces, vsize));
+	VL_CHECK(NULL != hit.map && hit.npoints == npoints);
+	vl_cached_point_cloud_free(&hit);
+
+	// Volume entries of the same mesh are separate, hit and miss agree with plain voxelization
+	volume = vl_volume_from_mesh(verts, nverts, faces, nfaces, vsize);
+	VL_CHECK(volume > 0.0);
+	VL_CHECK(vl_cached_volume_from_mesh(dir, 0.0, verts, nverts, faces, nfaces, vsize) == volume);
+	VL_CHECK(vl_cached_volume_from_mesh(dir, 0.0, verts, nverts, faces, nfaces, vsize) == volume);
+
+	// Eviction drops temporary files older than VL_CACHE_TEMP_AGE only
+	stale = vl_cache_path(dir, key, ".1.2.0.tmp");
+	fresh = vl_cache_path(dir, key, ".1.3.0.tmp");
+	if (stale && fresh) {
+#ifdef _WIN32
+		struct _utimbuf times;
+#else
+		struct utimbuf times;
+#endif
+		fclose(fopen(stale, "wb"));
+		fclose(fopen(fresh, "wb"));
+		times.actime = times.modtime = time(NULL) - 2 * VL_CACHE_TEMP_AGE;
+#ifdef _WIN32
+		_utime(stale, &times);
+#else
+		utime(stale, &times);
+#endif
+		vl_cache_evict(dir, 1e18);
+		VL_CHECK(!test_exists(stale));
+		VL_CHECK(test_exists(fresh));
+		VL_CHECK(test_exists(path));
+		remove(fresh);
+	}
+	free(stale);
+	free(fresh);
+
+	// Entries are evicted down to max_bytes
+	vl_cache_evict(dir, 0.5);
+	VL_CHECK(!test_exists(path));
+	VL_CHECK(test_rmdir(dir) == 0);
+	free(path);
+	free(points);
+	free(verts);
+	free(faces);
+}
+
+static void test_grid_set(VL_VoxelGrid * grid, VL_Size x, VL_Size y, VL_Size z) {
+	vl_grid_row(grid, y, z)[x / 64] |= (uint64_t)1 << (x % 64);
+}
+
+
+/*
+ * Voxels whose labels differ from a flood fill in scan order, or whose component stats differ
+ */
+static long test_labels_mismatches(const VL_VoxelGrid * grid, VL_Connectivity connectivity) {
+	const long cx = grid->header.cx, cy = grid->header.cy, cz = grid->header.cz, n = cx * cy * cz;
+	const int reach = connectivity == VL_EConnect6 ? 1 : connectivity == VL_EConnect18 ? 2 : 3;
+	VL_Size * ref = (VL_Size *)calloc(n, sizeof(VL_Size));
+	long * stack = (long *)malloc(sizeof(long) * n);
+	VL_Size nref = 0;
+	VL_Labels labels;
+	long nbad = 0;
+
+	if (!vl_labels_from_grid(&labels, grid, connectivity, 0)) {
+		free(ref);
+		free(stack);
+		return -1;
+	}
+	for (long i = 0; i < n; i++) {
+		long nstack = 0;
+		if (ref[i] || !vl_grid_get(grid, i % cx, i / cx % cy, i / cx / cy)) {
+			continue;
+		}
+		ref[i] = ++nref;
+		stack[nstack++] = i;
+		while (nstack > 0) {
+			const long j = stack[--nstack], x = j % cx, y = j / cx % cy, z = j / cx / cy;
+			for (int dz = -1; dz <= 1; dz++) {
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						const long k = ((z + dz) * cy + y + dy) * cx + x + dx;
+						if ((abs(dx) + abs(dy) + abs(dz) > reach) ||
+							(x + dx >= cx) || (y + dy >= cy) || (z + dz >= cz) ||
+							!test_grid_at(grid, x + dx, y + dy, z + dz) || ref[k]) {
+							continue;
+						}
+						ref[k] = nref;
+						stack[nstack++] = k;
+					}
+				}
+			}
+		}
+	}
+	nbad += labels.ncomponents != nref;
+	for (long i = 0; i < n; i++) {
+		const VL_Size x = i % cx, y = i / cx % cy, z = i / cx / cy;
+		nbad += vl_labels_at(&labels, x, y, z) != ref[i];
+	}
+	for (VL_Size l = 1; (l <= nref) && (l <= labels.ncomponents); l++) {
+		const VL_Component * c = labels.components + l - 1;
+		VL_Size count = 0;
+		for (long i = 0; i < n; i++) {
+			const VL_Size x = i % cx, y = i / cx % cy, z = i / cx / cy;
+			if (ref[i] == l) {
+				count++;
+				nbad += (x < c->minx) || (x > c->maxx) || (y < c->miny) || (y > c->maxy) || (z < c->minz) || (z > c->maxz);
+			}
+		}
+		nbad += c->count != count;
+	}
+	vl_labels_free(&labels);
+	free(ref);
+	free(stack);
+	return nbad;
+}
+
+
+static void test_labels() {
+	const VL_Connectivity connectivities[3] = { VL_EConnect6, VL_EConnect18, VL_EConnect26 };
+	VL_VoxelGrid grid, kept;
+	VL_Labels labels;
+
+	// Every neighbour of a voxel, across a word of x and across a slab of z, joins it from its reach on
+	VL_CHECK(test_random_grid(&grid, 130, 3, VL_LABELS_SLAB * 2 + 1, 0.0, 0.0, 0.0, 1.0, 0.0));
+	for (int dz = -1; dz <= 1; dz++) {
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dx = -1; dx <= 1; dx++) {
+				const int m = abs(dx) + abs(dy) + abs(dz);
+				if (m == 0) {
+					continue;
+				}
+				memset(grid.bits, 0, sizeof(uint64_t) * grid.nwords * grid.header.cy * grid.header.cz);
+				test_grid_set(&grid, 64, 1, VL_LABELS_SLAB);
+				test_grid_set(&grid, 64 + dx, 1 + dy, VL_LABELS_SLAB + dz);
+				for (int c = 0; c < 3; c++) {
+					VL_CHECK(vl_labels_from_grid(&labels, &grid, connectivities[c], 0));
+					VL_CHECK(labels.ncomponents == (m <= c + 1 ? 1 : 2));
+					vl_labels_free(&labels);
+				}
+			}
+		}
+	}
+	vl_grid_free(&grid);
+
+	// U of 21 voxels whose arms join past a slab boundary, a diagonal staircase of 5 voxels and a lone voxel
+	VL_CHECK(test_random_grid(&grid, 24, 6, VL_LABELS_SLAB + 4, 0.0, 0.0, 0.0, 1.0, 0.0));
+	for (VL_Size z = 0; z < 10; z++) {
+		test_grid_set(&grid, 0, 0, z);
+		test_grid_set(&grid, 2, 0, z);
+	}
+	test_grid_set(&grid, 1, 0, 9);
+	for (VL_Size k = 0; k < 5; k++) {
+		test_grid_set(&grid, 10 + k, k, k);
+	}
+	test_grid_set(&grid, 20, 3, 2);
+
+	// Labels follow scan order of first voxels, z then y then x
+	VL_CHECK(vl_labels_from_grid(&labels, &grid, VL_EConnect6, 0));
+	VL_CHECK(labels.ncomponents == 7);
+	VL_CHECK(vl_labels_at(&labels, 0, 0, 0) == 1 && vl_labels_at(&labels, 2, 0, 0) == 1);
+	VL_CHECK(vl_labels_at(&labels, 10, 0, 0) == 2 && vl_labels_at(&labels, 11, 1, 1) == 3);
+	VL_CHECK(vl_labels_at(&labels, 12, 2, 2) == 4 && vl_labels_at(&labels, 20, 3, 2) == 5);
+	VL_CHECK(vl_labels_at(&labels, 14, 4, 4) == 7 && vl_labels_at(&labels, 1, 0, 0) == 0);
+	VL_CHECK(labels.components[0].count == 21);
+	VL_CHECK(labels.components[0].minx == 0 && labels.components[0].maxx == 2);
+	VL_CHECK(labels.components[0].miny == 0 && labels.components[0].maxy == 0);
+	VL_CHECK(labels.components[0].minz == 0 && labels.components[0].maxz == 9);
+	vl_labels_free(&labels);
+	VL_CHECK(vl_labels_from_grid(&labels, &grid, VL_EConnect18, 0));
+	VL_CHECK(labels.ncomponents == 7);
+	vl_labels_free(&labels);
+	VL_CHECK(vl_labels_from_grid(&labels, &grid, VL_EConnect26, 0));
+	VL_CHECK(labels.ncomponents == 3);
+	VL_CHECK(vl_labels_at(&labels, 14, 4, 4) == 2 && vl_labels_at(&labels, 20, 3, 2) == 3);
+	VL_CHECK(labels.components[1].count == 5);
+	VL_CHECK(labels.components[1].minx == 10 && labels.components[1].maxz == 4);
+	vl_labels_free(&labels);
+
+	// Keeping the largest relabels by decreasing size and drops the rest
+	VL_CHECK(vl_labels_from_grid(&labels, &grid, VL_EConnect26, 2));
+	VL_CHECK(labels.ncomponents == 2);
+	VL_CHECK(labels.components[0].count == 21 && labels.components[1].count == 5);
+	VL_CHECK(vl_labels_at(&labels, 12, 2, 2) == 2 && vl_labels_at(&labels, 20, 3, 2) == 0);
+	VL_CHECK(vl_grid_from_labels(&kept, &labels, 2));
+	VL_CHECK(vl_grid_count(&kept) == 5 && vl_grid_get(&kept, 13, 3, 3));
+	vl_grid_free(&kept);
+	VL_CHECK(vl_grid_from_labels(&kept, &labels, 0));
+	VL_CHECK(vl_grid_count(&kept) == 26 && !vl_grid_get(&kept, 20, 3, 2));
+	vl_grid_free(&kept);
+	vl_labels_free(&labels);
+	for (int c = 0; c < 3; c++) {
+		VL_CHECK(test_labels_mismatches(&grid, connectivities[c]) == 0);
+	}
+	vl_grid_free(&grid);
+
+	// Random grids against flood fill, from sparse to mostly percolating
+	srand(5);
+	for (int t = 0; t < 3; t++) {
+		VL_CHECK(test_random_grid(&grid, 70 + t * 30, 17, 2 * VL_LABELS_SLAB + 3, 0.0, 0.0, 0.0, 1.0, 0.2 + 0.1 * t));
+		for (int c = 0; c < 3; c++) {
+			VL_CHECK(test_labels_mismatches(&grid, connectivities[c]) == 0);
+		}
+		vl_grid_free(&grid);
+	}
+}
+
+static bool test_in_element(VL_MorphElement element, int r, int dx, int dy, int dz) {
+	if ((abs(dx) > r) || (abs(dy) > r) || (abs(dz) > r)) {
+		return false;
+	}
+	if (element == VL_EElementBox) {
+		return true;
+	}
+	if (element == VL_EElementCross) {
+		return (dx != 0) + (dy != 0) + (dz != 0) <= 1;
+	}
+	return dx * dx + dy * dy + dz * dz <= r * r;
+}
+
+
+/*
+ * Naive dilation or erosion at voxel (x, y, z) of frame of grid, voxels out of frame are empty
+ */
+static bool test_morph_at(const VL_VoxelGrid * grid, VL_MorphOp op, VL_MorphElement element, int r, long x, long y, long z) {
+	const bool dilate = op == VL_EMorphDilate;
+	for (int dz = -r; dz <= r; dz++) {
+		for (int dy = -r; dy <= r; dy++) {
+			for (int dx = -r; dx <= r; dx++) {
+				if (test_in_element(element, r, dx, dy, dz) && (test_grid_at(grid, x + dx, y + dy, z + dz) == dilate)) {
+					return dilate;
+				}
+			}
+		}
+	}
+	return !dilate;
+}
+
+
+/*
+ * Voxels where morphology differs from neighbour loops, close and open compose the naive operations
+ */
+static long test_morph_mismatches(const VL_VoxelGrid * grid, VL_MorphOp op, VL_MorphElement element, int r) {
+	const long cx = grid->header.cx, cy = grid->header.cy, cz = grid->header.cz;
+	const long off = op == VL_EMorphDilate ? r : 0;
+	VL_VoxelGrid out, mid;
+	VL_VoxelHeader header = grid->header;
+	long nbad = 0;
+
+	if (!vl_grid_morphology(&out, grid, op, element, (VL_Size)r)) {
+		return -1;
+	}
+	if ((out.header.cx != (VL_Size)(cx + 2 * off)) || (out.header.cy != (VL_Size)(cy + 2 * off)) ||
+		(out.header.cz != (VL_Size)(cz + 2 * off))) {
+		vl_grid_free(&out);
+		return -1;
+	}
+	nbad += fabs(out.header.origin.x - (grid->header.origin.x - off * grid->header.vsize)) > 1e-5;
+	// Intermediate of close is dilated into a frame grown by r, of open eroded in the frame of grid
+	header.cx = cx + 2 * r;
+	header.cy = cy + 2 * r;
+	header.cz = cz + 2 * r;
+	if (!vl_grid_alloc(&mid, (op == VL_EMorphOpen) ? &grid->header : &header)) {
+		vl_grid_free(&out);
+		return -1;
+	}
+	if ((op == VL_EMorphClose) || (op == VL_EMorphOpen)) {
+		const long moff = op == VL_EMorphClose ? r : 0;
+		const VL_MorphOp first = op == VL_EMorphClose ? VL_EMorphDilate : VL_EMorphErode;
+		for (long z = 0; z < (long)mid.header.cz; z++) {
+			for (long y = 0; y < (long)mid.header.cy; y++) {
+				for (long x = 0; x < (long)mid.header.cx; x++) {
+					if (test_morph_at(grid, first, element, r, x - moff, y - moff, z - moff)) {
+						test_grid_set(&mid, x, y, z);
+					}
+				}
+			}
+		}
+	}
+	for (long z = 0; z < (long)out.header.cz; z++) {
+		for (long y = 0; y < (long)out.header.cy; y++) {
+			for (long x = 0; x < (long)out.header.cx; x++) {
+				bool ref;
+				if (op == VL_EMorphClose) {
+					ref = test_morph_at(&mid, VL_EMorphErode, element, r, x + r, y + r, z + r);
+				} else if (op == VL_EMorphOpen) {
+					ref = test_morph_at(&mid, VL_EMorphDilate, element, r, x, y, z);
+				} else {
+					ref = test_morph_at(grid, op, element, r, x - off, y - off, z - off);
+				}
+				nbad += ref != vl_grid_get(&out, x, y, z);
+			}
+		}
+	}
+	// Bits past cx stay clear
+	if (out.header.cx % 64) {
+		for (VL_Size row = 0; row < out.header.cy * out.header.cz; row++) {
+			nbad += (out.bits[row * out.nwords + out.nwords - 1] >> (out.header.cx % 64)) != 0;
+		}
+	}
+	vl_grid_free(&mid);
+	vl_grid_free(&out);
+	return nbad;
+}
+
+
+static void test_morphology() {
+	const VL_MorphOp ops[4] = { VL_EMorphDilate, VL_EMorphErode, VL_EMorphClose, VL_EMorphOpen };
+	const VL_MorphElement elements[3] = { VL_EElementBox, VL_EElementCross, VL_EElementSphere };
+	VL_VoxelGrid grid, out;
+
+	// Noise around a solid block spanning a word boundary of x, so erosion keeps something
+	srand(7);
+	VL_CHECK(test_random_grid(&grid, 70, 13, 11, 0.0, 0.0, 0.0, 0.5, 0.25));
+	for (VL_Size z = 2; z < 10; z++) {
+		for (VL_Size y = 1; y < 12; y++) {
+			vl_grid_row_fill(vl_grid_row(&grid, y, z), 5, 66);
+		}
+	}
+	for (int o = 0; o < 4; o++) {
+		for (int e = 0; e < 3; e++) {
+			for (int r = 0; r <= 4; r++) {
+				VL_CHECK(test_morph_mismatches(&grid, ops[o], elements[e], r) == 0);
+			}
+		}
+	}
+
+	// Frame grown past VL_Size is rejected rather than wrapped
+	VL_CHECK(!vl_grid_morphology(&out, &grid, VL_EMorphDilate, VL_EElementBox, (VL_Size)-1 / 2));
+	VL_CHECK(!vl_grid_morphology(&out, &grid, VL_EMorphClose, VL_EElementSphere, (VL_Size)-1 - 8));
+	VL_CHECK(NULL == out.bits);
+	// Erosion by a radius past the frame empties it without sweeping that radius
+	VL_CHECK(vl_grid_morphology(&out, &grid, VL_EMorphErode, VL_EElementSphere, (VL_Size)-1 / 4));
+	VL_CHECK(out.header.cx == grid.header.cx && vl_grid_count(&out) == 0);
+	vl_grid_free(&out);
+	vl_grid_free(&grid);
+}
+
+int main() {
+	test_vec3_cross();
+	test_proj_setup();
+	test_morton();
+	test_grid_overflow();
+	test_svo();
+	test_format_float();
+	test_write_mesh();
+	test_mesh_desc_indices();
+	test_grid_boolean();
+	test_mass_properties();
+	test_mesh_prepare();
+	test_proj_trace();
+	test_proj_trace_tiles();
+	test_cache();
+	test_labels();
+	test_morphology();
+
+	printf("%d failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
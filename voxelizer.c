@@ -1,14 +1,33 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "voxelizer.h"
 
 #include <math.h>
 #include <float.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <io.h>
+#include <process.h>
+#include <sys/utime.h>
+#define vl_fd_write(fd, buf, n) _write((fd), (buf), (unsigned int)(n))
+#define vl_fd_read(fd, buf, n) _read((fd), (buf), (unsigned int)(n))
 #else
 #include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/mman.h>
+#define vl_fd_write(fd, buf, n) write((fd), (buf), (n))
+#define vl_fd_read(fd, buf, n) read((fd), (buf), (n))
 #endif
 
 
@@ -20,6 +39,37 @@ typedef enum {
 } VL_ProjectDirection;
 
 
+/*
+ * Per axis triangle setup, stored as structure of arrays so trace loops
+ * stream through it linearly instead of gathering vertices through faces.
+ * Bounding boxes are already widened by half voxel, edge function of edge k
+ * is tri_a[k] * x + tri_b[k] * y + tri_c[k] and is negative only when the
+ * whole voxel lies outside of that edge.
+ * Triangles seen edge-on in this projection have no area and are kept as
+ * segments instead, voxel hits segment when |seg_a * x + seg_b * y + seg_c| <= seg_r.
+ * Outline edges bound the union of all primitives, they are kept in the same way as segments
+ * but widened a bit further, so voxels beyond every outline edge hit all or none of their tile.
+ */
+typedef struct {
+	VL_Size    ntris;
+	VL_Float * tri_minx, * tri_miny, * tri_maxx, * tri_maxy;
+	VL_Float * tri_a[3], * tri_b[3], * tri_c[3];
+	VL_Size    nsegs;
+	VL_Float * seg_minx, * seg_miny, * seg_maxx, * seg_maxy;
+	VL_Float * seg_a, * seg_b, * seg_c, * seg_r;
+	VL_Size    nedges;
+	VL_Float * edge_minx, * edge_miny, * edge_maxx, * edge_maxy;
+	VL_Float * edge_a, * edge_b, * edge_c, * edge_r;
+	VL_Float * block;
+} VL_ProjSetup;
+
+
+/*
+ * Edge length of square tiles projection planes are traced by
+ */
+#define VL_TRACE_TILE 16
+
+
 
 /*
  * STATIC
@@ -50,33 +100,6 @@ _VL_STATIC_ VL_Size vl_get_cpu_count() {
 }
 
 
-_VL_STATIC_ bool vl_is_voxel_tri_intersected_proj(
-	_VL_IN_ VL_ProjectDirection project_axis,
-	_VL_IN_ const VL_Vector3F * const t0,
-	_VL_IN_ const VL_Vector3F * const t1,
-	_VL_IN_ const VL_Vector3F * const t2,
-	_VL_IN_ const VL_Vector3F * const vcenter,
-	_VL_IN_ const VL_Float vsize
-	);
-
-
-_VL_STATIC_ bool vl_is_lineseg_intersected_proj(
-	_VL_OUT_ VL_Vector3F * out,
-	_VL_IN_  VL_ProjectDirection project_axis,
-	_VL_IN_  const VL_Vector3F * const beg1, const VL_Vector3F * end1,
-	_VL_IN_  const VL_Vector3F * const beg2, const VL_Vector3F * end2
-	);
-
-
-_VL_STATIC_ bool vl_is_vert_in_tri_proj(
-	_VL_IN_ VL_ProjectDirection project_axis,
-	_VL_IN_ const VL_Vector3F * const v,
-	_VL_IN_ const VL_Vector3F * const t0,
-	_VL_IN_ const VL_Vector3F * const t1,
-	_VL_IN_ const VL_Vector3F * const t2
-	);
-
-
 _VL_STATIC_ void vl_proj_vert_front(VL_Vector3F * dst, const VL_Vector3F * const src) {
 	VL_Vector3F temp = { src->x, src->y, src->z };
 	dst->x = temp.x;
@@ -101,353 +124,3344 @@ _VL_STATIC_ void vl_proj_vert_top(VL_Vector3F * dst, const VL_Vector3F * const s
 }
 
 
-_VL_STATIC_ bool vl_is_lineseg_intersected_proj(
-	_VL_OUT_ VL_Vector3F * out,
-	_VL_IN_  VL_ProjectDirection project_axis,
-	_VL_IN_  const VL_Vector3F * const beg1, const VL_Vector3F * const end1,
-	_VL_IN_  const VL_Vector3F * const beg2, const VL_Vector3F * const end2
+/*
+ * Describe tightly packed VL_Vector3F vertices and VL_Size faces
+ */
+_VL_STATIC_ void vl_mesh_desc_native(
+	_VL_OUT_ VL_MeshDesc * const       desc,
+	_VL_IN_  const VL_Vector3F * const verts,
+	_VL_IN_  const VL_Size             nverts,
+	_VL_IN_  const VL_Size * const     faces,
+	_VL_IN_  const VL_Size             nfaces
 	) {
-	VL_Vector3F a, b, c, d;
-	switch (project_axis) {
-		case VL_EProjectNone:
-			a.x = beg1->x; a.y = beg1->y; a.z = beg1->z;
-			b.x = end1->x; b.y = end1->y; b.z = end1->z;
-			c.x = beg2->x; c.y = beg2->y; c.z = beg2->z;
-			d.x = end2->x; d.y = end2->y; d.z = end2->z;
-			break;
-		case VL_EProjectFront:
-			vl_proj_vert_front(&a, beg1);
-			vl_proj_vert_front(&b, end1);
-			vl_proj_vert_front(&c, beg2);
-			vl_proj_vert_front(&d, end2);
+	desc->verts       = verts;
+	desc->vert_type   = sizeof(VL_Float) == sizeof(float) ? VL_EComponentFloat32 : VL_EComponentFloat64;
+	desc->vert_stride = sizeof(VL_Vector3F);
+	desc->nverts      = nverts;
+	desc->faces       = faces;
+	desc->face_type   = sizeof(VL_Size) == sizeof(uint16_t) ? VL_EIndexU16 :
+						sizeof(VL_Size) == sizeof(uint32_t) ? VL_EIndexU32 : VL_EIndexU64;
+	desc->nfaces      = nfaces;
+}
+
+
+_VL_STATIC_ void vl_mesh_desc_vert(VL_Vector3F * const out, const VL_MeshDesc * const desc, const VL_Size i) {
+	const size_t packed = desc->vert_type == VL_EComponentFloat32 ? sizeof(float) * 3 : sizeof(double) * 3;
+	const unsigned char * p = (const unsigned char *)desc->verts + (size_t)i * (desc->vert_stride ? desc->vert_stride : packed);
+	if (desc->vert_type == VL_EComponentFloat32) {
+		float v[3];
+		memcpy(v, p, sizeof(v));
+		out->x = v[0]; out->y = v[1]; out->z = v[2];
+	} else {
+		double v[3];
+		memcpy(v, p, sizeof(v));
+		out->x = (VL_Float)v[0]; out->y = (VL_Float)v[1]; out->z = (VL_Float)v[2];
+	}
+}
+
+
+/*
+ * Vertex index of corner k of face f
+ */
+_VL_STATIC_ VL_Size vl_mesh_desc_index(const VL_MeshDesc * const desc, const VL_Size f, const int k) {
+	switch (desc->face_type) {
+		case VL_EIndexU16: return (VL_Size)((const uint16_t *)desc->faces)[f * 3 + k];
+		case VL_EIndexU32: return (VL_Size)((const uint32_t *)desc->faces)[f * 3 + k];
+		case VL_EIndexU64: return (VL_Size)((const uint64_t *)desc->faces)[f * 3 + k];
+	}
+	return 0;
+}
+
+
+/*
+ * Whether mesh has faces and every index refers to one of its vertices
+ * Indices are compared at their own width, so 64 bit indices can not wrap into range through VL_Size
+ */
+_VL_STATIC_ bool vl_mesh_desc_is_valid(const VL_MeshDesc * const desc) {
+	const size_t n = (size_t)desc->nfaces * 3;
+	uint64_t max_index = 0;
+
+	if ((desc->nverts == 0) || (desc->nfaces == 0)) {
+		return false;
+	}
+	switch (desc->face_type) {
+		case VL_EIndexU16:
+			for (size_t i = 0; i < n; i++) {
+				max_index = VL_MAX(max_index, (uint64_t)((const uint16_t *)desc->faces)[i]);
+			}
 			break;
-		case VL_EProjectLeft:
-			vl_proj_vert_left(&a, beg1);
-			vl_proj_vert_left(&b, end1);
-			vl_proj_vert_left(&c, beg2);
-			vl_proj_vert_left(&d, end2);
+		case VL_EIndexU32:
+			for (size_t i = 0; i < n; i++) {
+				max_index = VL_MAX(max_index, (uint64_t)((const uint32_t *)desc->faces)[i]);
+			}
 			break;
-		case VL_EProjectTop:
-			vl_proj_vert_top(&a, beg1);
-			vl_proj_vert_top(&b, end1);
-			vl_proj_vert_top(&c, beg2);
-			vl_proj_vert_top(&d, end2);
+		case VL_EIndexU64:
+			for (size_t i = 0; i < n; i++) {
+				max_index = VL_MAX(max_index, ((const uint64_t *)desc->faces)[i]);
+			}
 			break;
+		default:
+			return false;
 	}
-	VL_Float area_abc = (a.x - c.x) * (b.y - c.y) - (a.y - c.y) * (b.x - c.x);
-	VL_Float area_abd = (a.x - d.x) * (b.y - d.y) - (a.y - d.y) * (b.x - d.x);
-	if ( area_abc * area_abd >= -FLT_EPSILON ) {
-		return false;
+	return max_index < (uint64_t)desc->nverts;
+}
+
+
+_VL_STATIC_ void vl_mesh_desc_tri(VL_Vector3F * const out, const VL_MeshDesc * const desc, const VL_Size f) {
+	vl_mesh_desc_vert(out + 0, desc, vl_mesh_desc_index(desc, f, 0));
+	vl_mesh_desc_vert(out + 1, desc, vl_mesh_desc_index(desc, f, 1));
+	vl_mesh_desc_vert(out + 2, desc, vl_mesh_desc_index(desc, f, 2));
+}
+
+
+_VL_STATIC_ void vl_mesh_desc_bbox(VL_Vector3F * const out_vmin, VL_Vector3F * const out_vmax, const VL_MeshDesc * const desc) {
+	VL_Vector3F v;
+	vl_mesh_desc_vert(out_vmin, desc, 0);
+	*out_vmax = *out_vmin;
+	for (VL_Size i = 1; i < desc->nverts; i++) {
+		vl_mesh_desc_vert(&v, desc, i);
+		out_vmin->x = VL_MIN(out_vmin->x, v.x);
+		out_vmin->y = VL_MIN(out_vmin->y, v.y);
+		out_vmin->z = VL_MIN(out_vmin->z, v.z);
+		out_vmax->x = VL_MAX(out_vmax->x, v.x);
+		out_vmax->y = VL_MAX(out_vmax->y, v.y);
+		out_vmax->z = VL_MAX(out_vmax->z, v.z);
+	}
+}
+
+
+/*
+ * LSD radix sort of 64 bit keys, values are moved along with keys if given
+ *
+ * Return:       false if memory allocation failed
+ * @keys:        Input and output keys
+ * @vals:        Optional input and output values
+ * @n:           Input key count
+ * @nbits:       Input count of low bits which may be set in keys
+ */
+_VL_STATIC_ bool vl_radix_sort_u64(uint64_t * keys, VL_Size * vals, const VL_Size n, const unsigned int nbits) {
+	const unsigned int radix = 11;
+	VL_Size count[1 << 11];
+	uint64_t * temp_keys;
+	VL_Size * temp_vals = NULL;
+
+	if (n < 2 || nbits == 0) {
+		return true;
 	}
-	VL_Float area_cda = (c.x - a.x) * (d.y - a.y) - (c.y - a.y) * (d.x - a.x);
-	VL_Float area_cdb = area_cda + area_abc - area_abd ;
-	if ( area_cda * area_cdb >= -FLT_EPSILON ) {
+	temp_keys = (uint64_t *)malloc(sizeof(uint64_t) * n);
+	if (vals) {
+		temp_vals = (VL_Size *)malloc(sizeof(VL_Size) * n);
+	}
+	if ((NULL == temp_keys) || (vals && (NULL == temp_vals))) {
+		free(temp_keys);
+		free(temp_vals);
 		return false;
 	}
-	VL_Float t  = area_cda / ( area_abd - area_abc );
-	VL_Float dx = t * (b.x - a.x);
-	VL_Float dy = t * (b.y - a.y);
-	if (out) {
-		out->x = a.x + dx;
-		out->y = a.y + dy;
+	for (unsigned int shift = 0; shift < nbits; shift += radix) {
+		VL_Size sum = 0;
+		uint64_t * swap_keys;
+		VL_Size * swap_vals;
+		memset(count, 0, sizeof(count));
+		for (VL_Size i = 0; i < n; i++) {
+			count[(keys[i] >> shift) & ((1 << radix) - 1)]++;
+		}
+		for (VL_Size d = 0; d < ((VL_Size)1 << radix); d++) {
+			VL_Size c = count[d];
+			count[d] = sum;
+			sum += c;
+		}
+		for (VL_Size i = 0; i < n; i++) {
+			VL_Size dst = count[(keys[i] >> shift) & ((1 << radix) - 1)]++;
+			temp_keys[dst] = keys[i];
+			if (vals) { temp_vals[dst] = vals[i]; }
+		}
+		swap_keys = keys; keys = temp_keys; temp_keys = swap_keys;
+		swap_vals = vals; vals = temp_vals; temp_vals = swap_vals;
+	}
+	// Odd pass count leaves result in temp buffers
+	if (((nbits + radix - 1) / radix) % 2) {
+		memcpy(temp_keys, keys, sizeof(uint64_t) * n);
+		if (vals) { memcpy(temp_vals, vals, sizeof(VL_Size) * n); }
+		free(keys);
+		free(vals);
+	} else {
+		free(temp_keys);
+		free(temp_vals);
 	}
-
 	return true;
 }
 
 
-_VL_STATIC_ bool vl_is_voxel_tri_intersected_proj(
-	_VL_IN_ VL_ProjectDirection project_axis,
-	_VL_IN_ const VL_Vector3F * const t0,
-	_VL_IN_ const VL_Vector3F * const t1,
-	_VL_IN_ const VL_Vector3F * const t2,
-	_VL_IN_ const VL_Vector3F * const vcenter,
-	_VL_IN_ const VL_Float vsize
+/*
+ * No partner face, see vl_mesh_desc_edge_partners
+ */
+#define VL_NO_PARTNER ((VL_Size)-1)
+
+
+/*
+ * Pair faces sharing an edge, edge k of face f runs from corner k to corner (k + 1) % 3 and is slot f * 3 + k,
+ * partner of a slot is the slot of the other face along that edge, or VL_NO_PARTNER when the edge is on
+ * a boundary, is shared by more than two faces or joins a vertex to itself
+ * Edges are matched by vertex index, so faces of an unwelded mesh have no partner at all
+ *
+ * Return:       false if memory allocation failed
+ * @out_partners: Output partner of every slot, should be freed
+ * @mesh:        Input mesh
+ */
+_VL_STATIC_ bool vl_mesh_desc_edge_partners(
+	_VL_OUT_ VL_Size ** const          out_partners,
+	_VL_IN_  const VL_MeshDesc * const mesh
 	) {
-	VL_Float halfsize = vsize / 2.0;
-	VL_Vector3F tmin, tmax, vmin, vmax;
-	VL_Vector3F pt0, pt1, pt2, pvcenter;
-	VL_Vector3F box[4];
-	switch (project_axis) {
-		case VL_EProjectNone:
-			pt0.x = t0->x; pt0.y = t0->y; pt0.z = t0->z;
-			pt1.x = t1->x; pt1.y = t1->y; pt1.z = t1->z;
-			pt2.x = t2->x; pt2.y = t2->y; pt2.z = t2->z;
-			pvcenter.x = vcenter->x; pvcenter.y = vcenter->y; pvcenter.z = vcenter->z;
-			break;
-		case VL_EProjectFront:
-			vl_proj_vert_front(&pt0, t0);
-			vl_proj_vert_front(&pt1, t1);
-			vl_proj_vert_front(&pt2, t2);
-			vl_proj_vert_front(&pvcenter, vcenter);
-			break;
-		case VL_EProjectLeft:
-			vl_proj_vert_left(&pt0, t0);
-			vl_proj_vert_left(&pt1, t1);
-			vl_proj_vert_left(&pt2, t2);
-			vl_proj_vert_left(&pvcenter, vcenter);
-			break;
-		case VL_EProjectTop:
-			vl_proj_vert_top(&pt0, t0);
-			vl_proj_vert_top(&pt1, t1);
-			vl_proj_vert_top(&pt2, t2);
-			vl_proj_vert_top(&pvcenter, vcenter);
-			break;
+	// Edge key is lower index * nverts + higher index, nverts * nverts is left for edges joining a vertex to itself
+	const uint64_t self_key = (uint64_t)mesh->nverts * mesh->nverts;
+	VL_Size nslots;
+	VL_Size * partners, * slots;
+	uint64_t * keys;
+	unsigned int nbits = 0;
+
+	*out_partners = NULL;
+	if (!((double)mesh->nfaces * 3 * sizeof(uint64_t) < VL_MIN((double)(VL_Size)-1, (double)SIZE_MAX))) {
+		return false;
 	}
-	tmin.x = VL_MIN(VL_MIN(pt0.x, pt1.x), pt2.x);
-	tmin.y = VL_MIN(VL_MIN(pt0.y, pt1.y), pt2.y);
-	tmax.x = VL_MAX(VL_MAX(pt0.x, pt1.x), pt2.x);
-	tmax.y = VL_MAX(VL_MAX(pt0.y, pt1.y), pt2.y);
-	vmin.x = pvcenter.x - halfsize;
-	vmin.y = pvcenter.y - halfsize;
-	vmax.x = pvcenter.x + halfsize;
-	vmax.y = pvcenter.y + halfsize;
-	box[0].x = pvcenter.x - halfsize; box[0].y = pvcenter.y + halfsize;
-	box[1].x = pvcenter.x + halfsize; box[1].y = pvcenter.y + halfsize;
-	box[2].x = pvcenter.x - halfsize; box[2].y = pvcenter.y - halfsize;
-	box[3].x = pvcenter.x + halfsize; box[3].y = pvcenter.y - halfsize;
-	// Seperated
-	if ((tmin.x > vmax.x) ||
-		(tmin.y > vmax.y) ||
-		(tmax.x < vmin.x) ||
-		(tmax.y < vmin.y)) {
-		return false;
-	}
-	// Voxel contains triangle
-	if ((tmin.x >= vmin.x) && (tmax.x <= vmax.x) &&
-		(tmin.y >= vmin.y) && (tmax.y <= vmax.y)) {
-		return true;
+	nslots = mesh->nfaces * 3;
+	partners = (VL_Size *)malloc(sizeof(VL_Size) * (nslots + 1));
+	if (NULL == partners) {
+		return false;
+	}
+	for (VL_Size s = 0; s < nslots; s++) {
+		partners[s] = VL_NO_PARTNER;
 	}
-	// Triangle contains voxel
-	if (vl_is_vert_in_tri_proj(VL_EProjectNone, box + 0, &pt0, &pt1, &pt2) ||
-		vl_is_vert_in_tri_proj(VL_EProjectNone, box + 1, &pt0, &pt1, &pt2) ||
-		vl_is_vert_in_tri_proj(VL_EProjectNone, box + 2, &pt0, &pt1, &pt2) ||
-		vl_is_vert_in_tri_proj(VL_EProjectNone, box + 3, &pt0, &pt1, &pt2)) {
+	// Keys do not fit 64 bits past 2^32 vertices, every edge is left on boundary then
+	if ((uint64_t)mesh->nverts > 0xffffffffULL) {
+		*out_partners = partners;
 		return true;
 	}
-	// Triangle intersected with voxel but no vertex of voxel is in triangle
-	if (vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt1, box + 0, box + 1) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt1, box + 2, box + 3) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt1, box + 0, box + 2) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt1, box + 1, box + 3) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt2, box + 0, box + 1) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt2, box + 2, box + 3) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt2, box + 0, box + 2) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt0, &pt2, box + 1, box + 3) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt1, &pt2, box + 0, box + 1) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt1, &pt2, box + 2, box + 3) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt1, &pt2, box + 0, box + 2) ||
-		vl_is_lineseg_intersected_proj(NULL, VL_EProjectNone, &pt1, &pt2, box + 1, box + 3)) {
-		    return true;
+	while ((nbits < 64) && (self_key >> nbits)) {
+		nbits++;
 	}
-	return false;
+	keys = (uint64_t *)malloc(sizeof(uint64_t) * (nslots + 1));
+	slots = (VL_Size *)malloc(sizeof(VL_Size) * (nslots + 1));
+	if ((NULL == keys) || (NULL == slots)) {
+		free(keys);
+		free(slots);
+		free(partners);
+		return false;
+	}
+	for (VL_Size f = 0; f < mesh->nfaces; f++) {
+		for (int k = 0; k < 3; k++) {
+			uint64_t a = vl_mesh_desc_index(mesh, f, k), b = vl_mesh_desc_index(mesh, f, (k + 1) % 3);
+			keys[f * 3 + k] = (a == b) ? self_key : VL_MIN(a, b) * mesh->nverts + VL_MAX(a, b);
+			slots[f * 3 + k] = f * 3 + k;
+		}
+	}
+	if (!vl_radix_sort_u64(keys, slots, nslots, nbits)) {
+		free(keys);
+		free(slots);
+		free(partners);
+		return false;
+	}
+	// Runs of equal keys are the faces around one edge, only runs of two are paired
+	for (VL_Size i = 0; i < nslots;) {
+		VL_Size j = i + 1;
+		while ((j < nslots) && (keys[j] == keys[i])) {
+			j++;
+		}
+		if ((j - i == 2) && (keys[i] != self_key)) {
+			partners[slots[i]] = slots[i + 1];
+			partners[slots[i + 1]] = slots[i];
+		}
+		i = j;
+	}
+	free(keys);
+	free(slots);
+	*out_partners = partners;
+	return true;
 }
 
 
-_VL_STATIC_ bool vl_is_vert_in_tri_proj(
-	_VL_IN_ VL_ProjectDirection project_axis,
-	_VL_IN_ const VL_Vector3F * const v,
-	_VL_IN_ const VL_Vector3F * const t0,
-	_VL_IN_ const VL_Vector3F * const t1,
-	_VL_IN_ const VL_Vector3F * const t2
-	) {
-	VL_Vector3F pv, pt0, pt1, pt2;
-	VL_Vector3F ab, ac, ap, ba, bc, bp;
-	VL_Vector3F r1, r2, r3, r4;
-	VL_Float dot1, dot2;
+_VL_STATIC_ void vl_proj_vert(VL_Vector3F * dst, const VL_Vector3F * const src, VL_ProjectDirection project_axis) {
 	switch (project_axis) {
-		case VL_EProjectNone:
-			pv.x = v->x; pv.y = v->y; pv.z = v->z;
-			pt0.x = t0->x; pt0.y = t0->y; pt0.z = t0->z;
-			pt1.x = t1->x; pt1.y = t1->y; pt1.z = t1->z;
-			pt2.x = t2->x; pt2.y = t2->y; pt2.z = t2->z;
-			break;
-		case VL_EProjectFront:
-			vl_proj_vert_front(&pv, v);
-			vl_proj_vert_front(&pt0, t0);
-			vl_proj_vert_front(&pt1, t1);
-			vl_proj_vert_front(&pt2, t2);
-			break;
-		case VL_EProjectLeft:
-			vl_proj_vert_left(&pv, v);
-			vl_proj_vert_left(&pt0, t0);
-			vl_proj_vert_left(&pt1, t1);
-			vl_proj_vert_left(&pt2, t2);
-			break;
-		case VL_EProjectTop:
-			vl_proj_vert_top(&pv, v);
-			vl_proj_vert_top(&pt0, t0);
-			vl_proj_vert_top(&pt1, t1);
-			vl_proj_vert_top(&pt2, t2);
-			break;
-	}
-	vl_vec3_sub(&ab, &pt1, &pt0);
-	vl_vec3_sub(&ac, &pt2, &pt0);
-	vl_vec3_sub(&ap, &pv, &pt0);
-	vl_vec3_sub(&ba, &pt0, &pt1);
-	vl_vec3_sub(&bc, &pt2, &pt1);
-	vl_vec3_sub(&bp, &pv, &pt1);
-	vl_vec3_cross(&r1, &ab, &ap);
-	vl_vec3_cross(&r2, &ap, &ac);
-	vl_vec3_cross(&r3, &bc, &bp);
-	vl_vec3_cross(&r4, &bp, &ba);
-	vl_vec3_dot(&dot1, &r1, &r2);
-	vl_vec3_dot(&dot2, &r3, &r4);
-	if ((dot1 < -FLT_EPSILON) || (dot2 < -FLT_EPSILON)) {
-		return false;
+		case VL_EProjectNone:  dst->x = src->x; dst->y = src->y; dst->z = src->z; break;
+		case VL_EProjectFront: vl_proj_vert_front(dst, src); break;
+		case VL_EProjectLeft:  vl_proj_vert_left(dst, src);  break;
+		case VL_EProjectTop:   vl_proj_vert_top(dst, src);   break;
 	}
-	return true;
 }
 
 
 /*
- * EXTERN
+ * Twice the signed area of projected triangle
  */
+_VL_STATIC_ VL_Float vl_tri_area2_proj(const VL_Vector3F * const p0, const VL_Vector3F * const p1, const VL_Vector3F * const p2) {
+	return (p1->x - p0->x) * (p2->y - p0->y) - (p1->y - p0->y) * (p2->x - p0->x);
+}
 
 
-_VL_EXTERN_ void vl_vec3_add(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
-	out->x = a->x + b->x;
-	out->y = a->y + b->y;
-	out->z = a->z + b->z;
+/*
+ * Projected triangle is degenerated when its area is negligible against its longest edge
+ */
+_VL_STATIC_ bool vl_is_tri_degenerated_proj(const VL_Vector3F * const p0, const VL_Vector3F * const p1, const VL_Vector3F * const p2) {
+	VL_Float area2 = vl_tri_area2_proj(p0, p1, p2);
+	VL_Float l01 = (p1->x - p0->x) * (p1->x - p0->x) + (p1->y - p0->y) * (p1->y - p0->y);
+	VL_Float l12 = (p2->x - p1->x) * (p2->x - p1->x) + (p2->y - p1->y) * (p2->y - p1->y);
+	VL_Float l20 = (p0->x - p2->x) * (p0->x - p2->x) + (p0->y - p2->y) * (p0->y - p2->y);
+	return fabs(area2) <= FLT_EPSILON * VL_MAX(VL_MAX(l01, l12), l20);
 }
 
 
-_VL_EXTERN_ void vl_vec3_sub(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
-	out->x = a->x - b->x;
-	out->y = a->y - b->y;
-	out->z = a->z - b->z;
+/*
+ * Whether edge k of face f, projected as p, may lie on the outline of the projected mesh
+ * An edge is inside the outline only when its partner face lies on the other side of it,
+ * sides are taken from areas well above rounding so that faces seen nearly edge-on count as outline
+ */
+_VL_STATIC_ bool vl_is_outline_edge_proj(
+	_VL_IN_  const VL_MeshDesc * const mesh,
+	_VL_IN_  const VL_Size * const     partners,
+	_VL_IN_  VL_ProjectDirection       project_axis,
+	_VL_IN_  const VL_Vector3F * const p,
+	_VL_IN_  const VL_Size             f,
+	_VL_IN_  const int                 k
+	) {
+	const VL_Vector3F * b = p + k, * e = p + (k + 1) % 3;
+	VL_Vector3F t[3], q[3];
+	VL_Float area0, area1, l = 0.0;
+	VL_Size g;
+
+	if ((NULL == partners) || (VL_NO_PARTNER == partners[f * 3 + k])) {
+		return true;
+	}
+	g = partners[f * 3 + k];
+	vl_mesh_desc_tri(t, mesh, g / 3);
+	vl_proj_vert(q + 0, t + 0, project_axis);
+	vl_proj_vert(q + 1, t + 1, project_axis);
+	vl_proj_vert(q + 2, t + 2, project_axis);
+	for (int i = 0; i < 3; i++) {
+		const VL_Vector3F * pb = p + i, * pe = p + (i + 1) % 3, * qb = q + i, * qe = q + (i + 1) % 3;
+		l = VL_MAX(l, (pe->x - pb->x) * (pe->x - pb->x) + (pe->y - pb->y) * (pe->y - pb->y));
+		l = VL_MAX(l, (qe->x - qb->x) * (qe->x - qb->x) + (qe->y - qb->y) * (qe->y - qb->y));
+	}
+	area0 = vl_tri_area2_proj(b, e, p + (k + 2) % 3);
+	area1 = vl_tri_area2_proj(b, e, q + (g % 3 + 2) % 3);
+	if ((fabs(area0) <= 16.0 * FLT_EPSILON * l) || (fabs(area1) <= 16.0 * FLT_EPSILON * l)) {
+		return true;
+	}
+	return (area0 > 0.0) == (area1 > 0.0);
 }
 
 
-_VL_EXTERN_ void vl_vec3_mul(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
-	out->x = a->x * b->x;
-	out->y = a->y * b->y;
-	out->z = a->z * b->z;
+_VL_STATIC_ void vl_proj_setup_free(VL_ProjSetup * setup) {
+	free(setup->block);
+	memset(setup, 0, sizeof(VL_ProjSetup));
 }
 
 
-_VL_EXTERN_ void vl_vec3_div(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
-	out->x = a->x / b->x;
-	out->y = a->y / b->y;
-	out->z = a->z / b->z;
-}
+/*
+ * Build triangle setup of one projection axis
+ *
+ * Return:       false if memory allocation failed
+ * @setup:       Output setup
+ * @project_axis Input projection axis
+ * @mesh:        Input mesh
+ * @partners:    Input edge partners from vl_mesh_desc_edge_partners, NULL takes every edge as outline
+ * @vsize:       Input voxel size
+ */
+_VL_STATIC_ bool vl_proj_setup_build(
+	_VL_OUT_ VL_ProjSetup * const      setup,
+	_VL_IN_  VL_ProjectDirection       project_axis,
+	_VL_IN_  const VL_MeshDesc * const mesh,
+	_VL_IN_  const VL_Size * const     partners,
+	_VL_IN_  const VL_Float            vsize
+	) {
+	const VL_Float halfsize = vsize / 2.0;
+	const VL_Size nfaces = mesh->nfaces;
+	VL_Vector3F t[3], p[3];
+	VL_Size ntris = 0, nsegs = 0, nedges = 0;
+	VL_Float * cursor;
 
+	memset(setup, 0, sizeof(VL_ProjSetup));
+	for (VL_Size f = 0; f < nfaces; f++) {
+		vl_mesh_desc_tri(t, mesh, f);
+		vl_proj_vert(p + 0, t + 0, project_axis);
+		vl_proj_vert(p + 1, t + 1, project_axis);
+		vl_proj_vert(p + 2, t + 2, project_axis);
+		if (vl_is_tri_degenerated_proj(p + 0, p + 1, p + 2)) {
+			nsegs++;
+		} else {
+			ntris++;
+		}
+		for (int k = 0; k < 3; k++) {
+			// A shared edge is kept once, by its lower slot
+			if (((NULL == partners) || (partners[f * 3 + k] > f * 3 + k)) &&
+				vl_is_outline_edge_proj(mesh, partners, project_axis, p, f, k)) {
+				nedges++;
+			}
+		}
+	}
+	setup->block = (VL_Float *)malloc(sizeof(VL_Float) * (ntris * 13 + (nsegs + nedges) * 8 + 1));
+	if (NULL == setup->block) {
+		return false;
+	}
+	cursor = setup->block;
+	setup->tri_minx = cursor; cursor += ntris;
+	setup->tri_miny = cursor; cursor += ntris;
+	setup->tri_maxx = cursor; cursor += ntris;
+	setup->tri_maxy = cursor; cursor += ntris;
+	for (int k = 0; k < 3; k++) {
+		setup->tri_a[k] = cursor; cursor += ntris;
+		setup->tri_b[k] = cursor; cursor += ntris;
+		setup->tri_c[k] = cursor; cursor += ntris;
+	}
+	setup->seg_minx = cursor; cursor += nsegs;
+	setup->seg_miny = cursor; cursor += nsegs;
+	setup->seg_maxx = cursor; cursor += nsegs;
+	setup->seg_maxy = cursor; cursor += nsegs;
+	setup->seg_a    = cursor; cursor += nsegs;
+	setup->seg_b    = cursor; cursor += nsegs;
+	setup->seg_c    = cursor; cursor += nsegs;
+	setup->seg_r    = cursor; cursor += nsegs;
+	setup->edge_minx = cursor; cursor += nedges;
+	setup->edge_miny = cursor; cursor += nedges;
+	setup->edge_maxx = cursor; cursor += nedges;
+	setup->edge_maxy = cursor; cursor += nedges;
+	setup->edge_a    = cursor; cursor += nedges;
+	setup->edge_b    = cursor; cursor += nedges;
+	setup->edge_c    = cursor; cursor += nedges;
+	setup->edge_r    = cursor; cursor += nedges;
 
-_VL_EXTERN_ void vl_vec3_dot(VL_Float * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
-	*out = a->x * b->x + a->y * b->y + a->z * b->z;
+	for (VL_Size f = 0; f < nfaces; f++) {
+		VL_Float minx, miny, maxx, maxy;
+		vl_mesh_desc_tri(t, mesh, f);
+		vl_proj_vert(p + 0, t + 0, project_axis);
+		vl_proj_vert(p + 1, t + 1, project_axis);
+		vl_proj_vert(p + 2, t + 2, project_axis);
+		minx = VL_MIN(VL_MIN(p[0].x, p[1].x), p[2].x) - halfsize;
+		miny = VL_MIN(VL_MIN(p[0].y, p[1].y), p[2].y) - halfsize;
+		maxx = VL_MAX(VL_MAX(p[0].x, p[1].x), p[2].x) + halfsize;
+		maxy = VL_MAX(VL_MAX(p[0].y, p[1].y), p[2].y) + halfsize;
+		if (vl_is_tri_degenerated_proj(p + 0, p + 1, p + 2)) {
+			// Line through the two farthest vertices
+			VL_Size i = setup->nsegs++;
+			const VL_Vector3F * b = p + 0, * e = p + 1;
+			VL_Float dx, dy, l = -1.0;
+			for (int k = 0; k < 3; k++) {
+				const VL_Vector3F * tb = p + k, * te = p + (k + 1) % 3;
+				VL_Float tl = (te->x - tb->x) * (te->x - tb->x) + (te->y - tb->y) * (te->y - tb->y);
+				if (tl > l) { l = tl; b = tb; e = te; }
+			}
+			dx = e->x - b->x;
+			dy = e->y - b->y;
+			setup->seg_minx[i] = minx;
+			setup->seg_miny[i] = miny;
+			setup->seg_maxx[i] = maxx;
+			setup->seg_maxy[i] = maxy;
+			setup->seg_a[i] = -dy;
+			setup->seg_b[i] =  dx;
+			setup->seg_c[i] =  dy * b->x - dx * b->y;
+			setup->seg_r[i] =  halfsize * (fabs(dx) + fabs(dy));
+		} else {
+			// Edge functions oriented so that inside is positive, widened by half voxel
+			VL_Size i = setup->ntris++;
+			VL_Float sign = vl_tri_area2_proj(p + 0, p + 1, p + 2) > 0.0 ? 1.0 : -1.0;
+			setup->tri_minx[i] = minx;
+			setup->tri_miny[i] = miny;
+			setup->tri_maxx[i] = maxx;
+			setup->tri_maxy[i] = maxy;
+			for (int k = 0; k < 3; k++) {
+				const VL_Vector3F * b = p + k, * e = p + (k + 1) % 3;
+				VL_Float a = -(e->y - b->y) * sign;
+				VL_Float c =  (e->x - b->x) * sign;
+				setup->tri_a[k][i] = a;
+				setup->tri_b[k][i] = c;
+				setup->tri_c[k][i] = -(a * b->x + c * b->y) + halfsize * (fabs(a) + fabs(c));
+			}
+		}
+		for (int k = 0; k < 3; k++) {
+			const VL_Vector3F * b = p + k, * e = p + (k + 1) % 3;
+			VL_Float dx = e->x - b->x, dy = e->y - b->y, widen;
+			VL_Size i;
+			if (((NULL != partners) && (partners[f * 3 + k] < f * 3 + k)) ||
+				!vl_is_outline_edge_proj(mesh, partners, project_axis, p, f, k)) {
+				continue;
+			}
+			// Widened past half voxel by a margin well above rounding of hit tests and voxel centers
+			widen = halfsize * (1.0 + 1.0 / 16.0) +
+					64.0 * FLT_EPSILON * VL_MAX(VL_MAX(fabs(b->x), fabs(b->y)), VL_MAX(fabs(e->x), fabs(e->y)));
+			i = setup->nedges++;
+			setup->edge_minx[i] = VL_MIN(b->x, e->x) - widen;
+			setup->edge_miny[i] = VL_MIN(b->y, e->y) - widen;
+			setup->edge_maxx[i] = VL_MAX(b->x, e->x) + widen;
+			setup->edge_maxy[i] = VL_MAX(b->y, e->y) + widen;
+			setup->edge_a[i] = -dy;
+			setup->edge_b[i] =  dx;
+			setup->edge_c[i] =  dy * b->x - dx * b->y;
+			setup->edge_r[i] =  widen * (fabs(dx) + fabs(dy));
+		}
+	}
+	return true;
 }
 
 
-_VL_EXTERN_ void vl_vec3_dist(VL_Float * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
-	VL_Float px = a->x * a->x;
-	VL_Float py = a->y * a->y;
-	VL_Float pz = a->z * a->z;
-	*out = sqrt(px + py + pz);
+_VL_STATIC_ bool vl_proj_setup_tri_hit(const VL_ProjSetup * const setup, const VL_Size i, const VL_Float px, const VL_Float py) {
+	if ((px < setup->tri_minx[i]) || (px > setup->tri_maxx[i]) ||
+		(py < setup->tri_miny[i]) || (py > setup->tri_maxy[i])) {
+		return false;
+	}
+	return (setup->tri_a[0][i] * px + setup->tri_b[0][i] * py + setup->tri_c[0][i] >= 0.0) &&
+		   (setup->tri_a[1][i] * px + setup->tri_b[1][i] * py + setup->tri_c[1][i] >= 0.0) &&
+		   (setup->tri_a[2][i] * px + setup->tri_b[2][i] * py + setup->tri_c[2][i] >= 0.0);
 }
 
 
-_VL_EXTERN_ void vl_vec3_cross(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
-	out->x = a->y * b->z - a->z * b->y;
-	out->y = a->z * b->x - a->x * b->z;
-	out->y = a->x * b->y - a->y * b->x;
+_VL_STATIC_ bool vl_proj_setup_seg_hit(const VL_ProjSetup * const setup, const VL_Size i, const VL_Float px, const VL_Float py) {
+	if ((px < setup->seg_minx[i]) || (px > setup->seg_maxx[i]) ||
+		(py < setup->seg_miny[i]) || (py > setup->seg_maxy[i])) {
+		return false;
+	}
+	return fabs(setup->seg_a[i] * px + setup->seg_b[i] * py + setup->seg_c[i]) <= setup->seg_r[i];
 }
 
 
-_VL_EXTERN_ VL_Float vl_volume_from_mesh(
-	_VL_IN_ const VL_Vector3F * const in_verts,
-	_VL_IN_ const VL_Size             in_nverts,
-	_VL_IN_ const VL_Size * const     in_faces,
-	_VL_IN_ const VL_Size             in_nfaces,
-	_VL_IN_ const VL_Float            in_vsize
+/*
+ * Test voxel centered at (px, py) on projection plane against primitives ids of setup,
+ * ids below ntris are triangles and the rest are segments
+ */
+_VL_STATIC_ bool vl_proj_setup_hit(
+	_VL_IN_  const VL_ProjSetup * const setup,
+	_VL_IN_  const VL_Size * const      ids,
+	_VL_IN_  const VL_Size              nids,
+	_VL_IN_  const VL_Float             px,
+	_VL_IN_  const VL_Float             py
 	) {
-	VL_Size npoints = 0;
-	VL_Vector3F * point_cloud;
-	point_cloud = vl_point_cloud_from_mesh(NULL, &npoints, in_verts, in_nverts, in_faces, in_nfaces, in_vsize);
-	free(point_cloud);
-	return in_vsize * in_vsize * in_vsize * npoints;
+	for (VL_Size k = 0; k < nids; k++) {
+		if ((ids[k] < setup->ntris) ?
+			vl_proj_setup_tri_hit(setup, ids[k], px, py) :
+			vl_proj_setup_seg_hit(setup, ids[k] - setup->ntris, px, py)) {
+			return true;
+		}
+	}
+	return false;
 }
 
 
-_VL_EXTERN_ void vl_mesh_from_point_cloud(
-	_VL_OUT_ VL_Vector3F ** const      out_verts,
-	_VL_OUT_ VL_Size * const           out_nverts,
-	_VL_OUT_ VL_Size ** const          out_faces,
-	_VL_OUT_ VL_Size * const           out_nfaces,
-	_VL_IN_  const VL_Vector3F * const in_point_cloud,
-	_VL_IN_  VL_Size                   in_npoints,
-	_VL_IN_  const VL_Float             in_vsize
+/*
+ * Pixel range [*out_begin, *out_end) of nu pixels centered at u0 + u * du which may fall in [lo, hi],
+ * widened by a pixel against rounding, as binning a primitive into an extra tile is harmless
+ */
+_VL_STATIC_ void vl_trace_pixel_range(
+	_VL_OUT_ VL_Size * const out_begin,
+	_VL_OUT_ VL_Size * const out_end,
+	_VL_IN_  const VL_Float  lo,
+	_VL_IN_  const VL_Float  hi,
+	_VL_IN_  const VL_Size   nu,
+	_VL_IN_  const VL_Float  u0,
+	_VL_IN_  const VL_Float  du
 	) {
-	VL_Float       halfsize = in_vsize / 2.0;
-	VL_Size       local_nverts = in_npoints * 8;
-	VL_Size       local_nfaces = in_npoints * 12;
-	VL_Vector3F * local_verts  = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * local_nverts);
-	VL_Size *     local_faces  = (VL_Size *)malloc(sizeof(VL_Size) * local_nfaces * 3);
-
-	*out_verts = NULL;
-	*out_nverts = 0;
-	*out_faces = NULL;
-	*out_nfaces = 0;
-	if ((NULL == local_verts) || (NULL == local_faces)) {
-		if (NULL != local_verts) free(local_verts);
-		if (NULL != local_faces) free(local_faces);
-		return;
+	double b = (lo - u0) / du, e = (hi - u0) / du;
+	if (b > e) {
+		double t = b; b = e; e = t;
 	}
+	b = ceil(b) - 1.0;
+	e = floor(e) + 2.0;
+	// Written so that NaN of a non finite primitive clamps to the whole range instead of reaching the casts
+	b = b > 0.0 ? VL_MIN(b, (double)nu) : 0.0;
+	e = e < (double)nu ? e : (double)nu;
+	*out_begin = (VL_Size)b;
+	*out_end = b < e ? (VL_Size)e : (VL_Size)b;
+}
 
-	for (VL_Size i = 0; i < in_npoints; i++) {
-		const VL_Vector3F * const point = in_point_cloud + i;
-
-		VL_Vector3F * p0 = local_verts + i * 8 + 0;
-		VL_Vector3F * p1 = p0 + 1;
-		VL_Vector3F * p2 = p1 + 1;
-		VL_Vector3F * p3 = p2 + 1;
-		VL_Vector3F * p4 = p3 + 1;
-		VL_Vector3F * p5 = p4 + 1;
-		VL_Vector3F * p6 = p5 + 1;
-		VL_Vector3F * p7 = p6 + 1;
 
-		p0->x = point->x + halfsize; p0->y = point->y - halfsize; p0->z = point->z + halfsize;
-		p1->x = point->x - halfsize; p1->y = point->y - halfsize; p1->z = point->z + halfsize;
-		p2->x = point->x + halfsize; p2->y = point->y + halfsize; p2->z = point->z + halfsize;
-		p3->x = point->x - halfsize; p3->y = point->y + halfsize; p3->z = point->z + halfsize;
-		p4->x = point->x + halfsize; p4->y = point->y - halfsize; p4->z = point->z - halfsize;
-		p5->x = point->x - halfsize; p5->y = point->y - halfsize; p5->z = point->z - halfsize;
-		p6->x = point->x + halfsize; p6->y = point->y + halfsize; p6->z = point->z - halfsize;
-		p7->x = point->x - halfsize; p7->y = point->y + halfsize; p7->z = point->z - halfsize;
+/*
+ * Voxel center rectangle of tile, pu and pv are ordered as voxels so they are swapped when du or dv is negative
+ */
+_VL_STATIC_ void vl_trace_tile_rect(
+	_VL_OUT_ VL_Float * const pu,
+	_VL_OUT_ VL_Float * const pv,
+	_VL_IN_  const VL_Size    tu,
+	_VL_IN_  const VL_Size    tv,
+	_VL_IN_  const VL_Size    nu,
+	_VL_IN_  const VL_Size    nv,
+	_VL_IN_  const VL_Float   u0,
+	_VL_IN_  const VL_Float   du,
+	_VL_IN_  const VL_Float   v0,
+	_VL_IN_  const VL_Float   dv
+	) {
+	const VL_Size ub = tu * VL_TRACE_TILE, vb = tv * VL_TRACE_TILE;
+	pu[0] = u0 + ub * du;
+	pu[1] = u0 + (VL_MIN(ub + VL_TRACE_TILE, nu) - 1) * du;
+	pv[0] = v0 + vb * dv;
+	pv[1] = v0 + (VL_MIN(vb + VL_TRACE_TILE, nv) - 1) * dv;
+}
 
-		VL_Size * f0  = local_faces + i * 12 * 3;
-		VL_Size * f1  = f0  + 3;
-		VL_Size * f2  = f1  + 3;
-		VL_Size * f3  = f2  + 3;
-		VL_Size * f4  = f3  + 3;
-		VL_Size * f5  = f4  + 3;
-		VL_Size * f6  = f5  + 3;
-		VL_Size * f7  = f6  + 3;
-		VL_Size * f8  = f7  + 3;
-		VL_Size * f9  = f8  + 3;
-		VL_Size * f10 = f9  + 3;
-		VL_Size * f11 = f10 + 3;
 
-		*f0  = i * 8 + 0; *(f0  + 1) = i * 8 + 1; *(f0  + 2) = i * 8 + 2; // 0 1 2
-		*f1  = i * 8 + 1; *(f1  + 1) = i * 8 + 2; *(f1  + 2) = i * 8 + 3; // 1 2 3
-		*f2  = i * 8 + 4; *(f2  + 1) = i * 8 + 5; *(f2  + 2) = i * 8 + 6; // 4 5 6
-		*f3  = i * 8 + 5; *(f3  + 1) = i * 8 + 6; *(f3  + 2) = i * 8 + 7; // 5 6 7
-		*f4  = i * 8 + 0; *(f4  + 1) = i * 8 + 1; *(f4  + 2) = i * 8 + 4; // 0 1 4
-		*f5  = i * 8 + 1; *(f5  + 1) = i * 8 + 4; *(f5  + 2) = i * 8 + 5; // 1 4 5
-		*f6  = i * 8 + 2; *(f6  + 1) = i * 8 + 3; *(f6  + 2) = i * 8 + 6; // 2 3 6
-		*f7  = i * 8 + 3; *(f7  + 1) = i * 8 + 6; *(f7  + 2) = i * 8 + 7; // 3 6 7
-		*f8  = i * 8 + 1; *(f8  + 1) = i * 8 + 3; *(f8  + 2) = i * 8 + 5; // 1 3 5
-		*f9  = i * 8 + 3; *(f9  + 1) = i * 8 + 5; *(f9  + 2) = i * 8 + 7; // 3 5 7
-		*f10 = i * 8 + 0; *(f10 + 1) = i * 8 + 2; *(f10 + 2) = i * 8 + 4; // 0 2 4
-		*f11 = i * 8 + 2; *(f11 + 1) = i * 8 + 4; *(f11 + 2) = i * 8 + 6; // 2 4 6
+/*
+ * Trace a projection plane of nu * nv voxels, voxel (u, v) is centered at (u0 + u * du, v0 + v * dv)
+ * Primitives are first binned into tiles of VL_TRACE_TILE * VL_TRACE_TILE voxels and outline edges
+ * flag the tiles they may cross. Hits only change across outline edges, so a tile without primitive
+ * is cleared at once and a tile no outline edge crosses is filled by the hit of one voxel, only tiles
+ * along the outline are tested voxel by voxel against their own primitive list, unless one triangle
+ * covers them as on open meshes whose boundary edges cross the inside of the outline
+ *
+ * Return:       false if memory allocation failed
+ * @out_nrefined: Optional output count of tiles tested voxel by voxel
+ */
+_VL_STATIC_ bool vl_proj_setup_trace(
+	_VL_IN_      const VL_ProjSetup * const setup,
+	_VL_OUT_     bool * const               buff,
+	_VL_IN_      const VL_Size              nu,
+	_VL_IN_      const VL_Size              nv,
+	_VL_IN_      const VL_Float             u0,
+	_VL_IN_      const VL_Float             du,
+	_VL_IN_      const VL_Float             v0,
+	_VL_IN_      const VL_Float             dv,
+	_VL_OPT_OUT_ VL_Size * const            out_nrefined
+	) {
+	const VL_Size ntu = (nu + VL_TRACE_TILE - 1) / VL_TRACE_TILE;
+	const VL_Size ntv = (nv + VL_TRACE_TILE - 1) / VL_TRACE_TILE;
+	const VL_Size nprims = setup->ntris + setup->nsegs;
+	VL_Size * offsets = (VL_Size *)calloc(ntu * ntv + 1, sizeof(VL_Size));
+	bool * crossed = (bool *)calloc(ntu * ntv + 1, sizeof(bool));
+	VL_Size * ids = NULL;
+	VL_Size nrefined = 0;
 
+	if ((NULL == offsets) || (NULL == crossed)) {
+		free(offsets);
+		free(crossed);
+		return false;
 	}
-	*out_nverts = local_nverts;
-	*out_nfaces = local_nfaces;
-	*out_verts  = local_verts;
-	*out_faces  = local_faces;
-}
-
-
+	// Bin primitives by bbox into tiles, counting first and filling second
+	for (int pass = 0; pass < 2; pass++) {
+		for (VL_Size i = 0; i < nprims; i++) {
+			const bool tri = i < setup->ntris;
+			const VL_Size j = tri ? i : i - setup->ntris;
+			VL_Size ub, ue, vb, ve;
+			vl_trace_pixel_range(&ub, &ue, tri ? setup->tri_minx[j] : setup->seg_minx[j],
+								 tri ? setup->tri_maxx[j] : setup->seg_maxx[j], nu, u0, du);
+			vl_trace_pixel_range(&vb, &ve, tri ? setup->tri_miny[j] : setup->seg_miny[j],
+								 tri ? setup->tri_maxy[j] : setup->seg_maxy[j], nv, v0, dv);
+			if ((ub >= ue) || (vb >= ve)) {
+				continue;
+			}
+			for (VL_Size tv = vb / VL_TRACE_TILE; tv <= (ve - 1) / VL_TRACE_TILE; tv++) {
+				for (VL_Size tu = ub / VL_TRACE_TILE; tu <= (ue - 1) / VL_TRACE_TILE; tu++) {
+					if (pass == 0) {
+						offsets[tv * ntu + tu + 1]++;
+					} else {
+						ids[offsets[tv * ntu + tu]++] = i;
+					}
+				}
+			}
+		}
+		if (pass == 0) {
+			// A tile holds at most nprims, but their sum may not fit VL_Size or a size_t byte count
+			double total = 1.0;
+			for (VL_Size t = 0; t < ntu * ntv; t++) {
+				total += (double)offsets[t + 1];
+				offsets[t + 1] += offsets[t];
+			}
+			if (!(total < (double)(VL_Size)-1) || !(total * sizeof(VL_Size) < (double)SIZE_MAX)) {
+				free(offsets);
+				free(crossed);
+				return false;
+			}
+			ids = (VL_Size *)malloc(sizeof(VL_Size) * (offsets[ntu * ntv] + 1));
+			if (NULL == ids) {
+				free(offsets);
+				free(crossed);
+				return false;
+			}
+		}
+	}
+	// Filling advanced every offset to the next tile's begin
+	for (VL_Size t = ntu * ntv; t > 0; t--) {
+		offsets[t] = offsets[t - 1];
+	}
+	offsets[0] = 0;
+
+	// Edge strip is linear in voxel center, so it misses tile when all four corners are beyond the same side
+	for (VL_Size i = 0; i < setup->nedges; i++) {
+		VL_Size ub, ue, vb, ve;
+		vl_trace_pixel_range(&ub, &ue, setup->edge_minx[i], setup->edge_maxx[i], nu, u0, du);
+		vl_trace_pixel_range(&vb, &ve, setup->edge_miny[i], setup->edge_maxy[i], nv, v0, dv);
+		if ((ub >= ue) || (vb >= ve)) {
+			continue;
+		}
+		for (VL_Size tv = vb / VL_TRACE_TILE; tv <= (ve - 1) / VL_TRACE_TILE; tv++) {
+			for (VL_Size tu = ub / VL_TRACE_TILE; tu <= (ue - 1) / VL_TRACE_TILE; tu++) {
+				VL_Float pu[2], pv[2], lo = 0.0, hi = 0.0;
+				if (crossed[tv * ntu + tu]) {
+					continue;
+				}
+				vl_trace_tile_rect(pu, pv, tu, tv, nu, nv, u0, du, v0, dv);
+				for (int c = 0; c < 4; c++) {
+					VL_Float d = setup->edge_a[i] * pu[c & 1] + setup->edge_b[i] * pv[c >> 1] + setup->edge_c[i];
+					lo = c ? VL_MIN(lo, d) : d;
+					hi = c ? VL_MAX(hi, d) : d;
+				}
+				crossed[tv * ntu + tu] = !((lo > setup->edge_r[i]) || (hi < -setup->edge_r[i]));
+			}
+		}
+	}
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:nrefined)
+	for (long t = 0; t < (long)(ntu * ntv); t++) {
+		const VL_Size ub = (VL_Size)t % ntu * VL_TRACE_TILE, vb = (VL_Size)t / ntu * VL_TRACE_TILE;
+		const VL_Size ue = VL_MIN(ub + VL_TRACE_TILE, nu), ve = VL_MIN(vb + VL_TRACE_TILE, nv);
+		const VL_Size * tile_ids = ids + offsets[t];
+		const VL_Size ntile_ids = offsets[t + 1] - offsets[t];
+		VL_Float pu[2], pv[2];
+		bool uniform = (ntile_ids == 0) || !crossed[t];
+		bool full = false;
+
+		vl_trace_tile_rect(pu, pv, (VL_Size)t % ntu, (VL_Size)t / ntu, nu, nv, u0, du, v0, dv);
+		if (uniform) {
+			full = (ntile_ids > 0) && vl_proj_setup_hit(setup, tile_ids, ntile_ids, pu[0], pv[0]);
+		}
+		// Hit test is linear in voxel center within bbox, so a triangle hit by all four corners covers tile
+		for (VL_Size k = 0; (k < ntile_ids) && !uniform; k++) {
+			if (tile_ids[k] < setup->ntris) {
+				uniform = full = vl_proj_setup_tri_hit(setup, tile_ids[k], pu[0], pv[0]) &&
+								 vl_proj_setup_tri_hit(setup, tile_ids[k], pu[1], pv[0]) &&
+								 vl_proj_setup_tri_hit(setup, tile_ids[k], pu[0], pv[1]) &&
+								 vl_proj_setup_tri_hit(setup, tile_ids[k], pu[1], pv[1]);
+			}
+		}
+		if (!uniform) {
+			nrefined++;
+		}
+		for (VL_Size v = vb; v < ve; v++) {
+			for (VL_Size u = ub; u < ue; u++) {
+				buff[v * nu + u] = uniform ? full :
+					vl_proj_setup_hit(setup, tile_ids, ntile_ids, u0 + u * du, v0 + v * dv);
+			}
+		}
+	}
+	free(offsets);
+	free(crossed);
+	free(ids);
+	if (out_nrefined) {
+		*out_nrefined = nrefined;
+	}
+	return true;
+}
+
+
+/*
+ * Check whether a grid would overflow VL_Size indices or size_t byte counts
+ * Dims are computed in double here, so this is safe to call before casting them to VL_Size
+ * Non finite bbox or voxel size counts as overflow, comparisons are negated so NaN fails them
+ */
+_VL_STATIC_ bool vl_is_grid_overflowed(
+	_VL_IN_ const VL_Vector3F * const vmin,
+	_VL_IN_ const VL_Vector3F * const vmax,
+	_VL_IN_ const VL_Size             nfaces,
+	_VL_IN_ const VL_Float            vsize
+	) {
+	const double size_max = (double)(VL_Size)-1;
+	const double bytes_max = (double)SIZE_MAX;
+	double cx, cy, cz;
+
+	if (!(vsize > 0.0)) {
+		return true;
+	}
+	cx = VL_MAX(ceil((vmax->x - vmin->x) / vsize), 1.0);
+	cy = VL_MAX(ceil((vmax->y - vmin->y) / vsize), 1.0);
+	cz = VL_MAX(ceil((vmax->z - vmin->z) / vsize), 1.0);
+	// Voxel count and linear voxel index
+	if (!(cx * cy * cz < size_max)) {
+		return true;
+	}
+	// Point cloud bytes, every voxel may be solid
+	if (!(cx * cy * cz * sizeof(VL_Vector3F) < bytes_max)) {
+		return true;
+	}
+	// Triangle setup table
+	if ((double)nfaces * 13 * sizeof(VL_Float) >= VL_MIN(size_max, bytes_max)) {
+		return true;
+	}
+	return false;
+}
+
+
+/*
+ * Mesh statistics which planning depends on, independent of voxel size
+ */
+typedef struct {
+	VL_Vector3F vmin, vmax;
+	VL_Size     nfaces;
+	// Enclosed volume, meaningful for closed meshes only
+	double      volume;
+	// Sum of triangle areas projected onto YZ, XZ and XY planes
+	double      proj_area;
+	// Count and summed L1 length of outline edges of the three projection planes
+	double      noutline;
+	double      outline_length;
+} VL_PlanStats;
+
+
+/*
+ * Return:       false if memory allocation failed
+ */
+_VL_STATIC_ bool vl_plan_stats_from_mesh(VL_PlanStats * const stats, const VL_MeshDesc * const mesh) {
+	const VL_ProjectDirection axes[3] = { VL_EProjectFront, VL_EProjectLeft, VL_EProjectTop };
+	double volume = 0.0;
+	VL_Size * partners;
+
+	memset(stats, 0, sizeof(VL_PlanStats));
+	if (!vl_mesh_desc_edge_partners(&partners, mesh)) {
+		return false;
+	}
+	vl_mesh_desc_bbox(&stats->vmin, &stats->vmax, mesh);
+	stats->nfaces = mesh->nfaces;
+	for (VL_Size f = 0; f < mesh->nfaces; f++) {
+		VL_Vector3F t[3], p[3];
+		const VL_Vector3F * p0 = t + 0, * p1 = t + 1, * p2 = t + 2;
+		vl_mesh_desc_tri(t, mesh, f);
+		// Same outline edges as vl_proj_setup_build keeps
+		for (int i = 0; i < 3; i++) {
+			vl_proj_vert(p + 0, t + 0, axes[i]);
+			vl_proj_vert(p + 1, t + 1, axes[i]);
+			vl_proj_vert(p + 2, t + 2, axes[i]);
+			for (int k = 0; k < 3; k++) {
+				if ((partners[f * 3 + k] > f * 3 + k) && vl_is_outline_edge_proj(mesh, partners, axes[i], p, f, k)) {
+					stats->noutline += 1.0;
+					stats->outline_length += fabs(p[(k + 1) % 3].x - p[k].x) + fabs(p[(k + 1) % 3].y - p[k].y);
+				}
+			}
+		}
+		double ax = p1->x - p0->x, ay = p1->y - p0->y, az = p1->z - p0->z;
+		double bx = p2->x - p0->x, by = p2->y - p0->y, bz = p2->z - p0->z;
+		double nx = ay * bz - az * by;
+		double ny = az * bx - ax * bz;
+		double nz = ax * by - ay * bx;
+		// Divergence theorem, signed volume of tetrahedron against origin
+		volume += (p0->x * (p1->y * p2->z - p1->z * p2->y) -
+				   p0->y * (p1->x * p2->z - p1->z * p2->x) +
+				   p0->z * (p1->x * p2->y - p1->y * p2->x)) / 6.0;
+		stats->proj_area += (fabs(nx) + fabs(ny) + fabs(nz)) / 2.0;
+	}
+	stats->volume = fabs(volume);
+	free(partners);
+	return true;
+}
+
+
+_VL_STATIC_ bool vl_plan_from_stats(VL_Plan * const plan, const VL_PlanStats * const stats, const VL_Float vsize) {
+	double cx, cy, cz, npixels, mask_bytes, setup_bytes, point_bytes;
+	double tu, tv, tw, ntiles, nbins, nedge_tiles;
+
+	memset(plan, 0, sizeof(VL_Plan));
+	plan->vsize = vsize;
+	plan->overflow = vl_is_grid_overflowed(&stats->vmin, &stats->vmax, stats->nfaces, vsize);
+	if (plan->overflow) {
+		return false;
+	}
+	cx = VL_MAX(ceil((stats->vmax.x - stats->vmin.x) / vsize), 1.0);
+	cy = VL_MAX(ceil((stats->vmax.y - stats->vmin.y) / vsize), 1.0);
+	cz = VL_MAX(ceil((stats->vmax.z - stats->vmin.z) / vsize), 1.0);
+
+	// Tile bins, each triangle lands in about its bbox worth of tiles, about twice its own area
+	tu = ceil(cx / VL_TRACE_TILE);
+	tv = ceil(cy / VL_TRACE_TILE);
+	tw = ceil(cz / VL_TRACE_TILE);
+	ntiles = tu * tw + tv * tw + tu * tv;
+	nbins = 3.0 * stats->nfaces + 2.0 * stats->proj_area / (vsize * vsize * VL_TRACE_TILE * VL_TRACE_TILE);
+	// Bins are indexed by VL_Size as well, vl_proj_setup_trace fails past that
+	if (!(nbins + ntiles < (double)(VL_Size)-1)) {
+		plan->overflow = true;
+		return false;
+	}
+	plan->cx = (VL_Size)cx;
+	plan->cy = (VL_Size)cy;
+	plan->cz = (VL_Size)cz;
+	npixels = cx * cz + cy * cz + cx * cy;
+
+	// Solid interior plus a surface shell about one voxel thick along each axis
+	plan->max_points = cx * cy * cz;
+	plan->est_points = VL_MIN(plan->max_points,
+			ceil(stats->volume / (vsize * vsize * vsize) + stats->proj_area / (vsize * vsize)));
+
+	// Tiles left to refine voxel by voxel are those outline edges cross, an edge crosses about one tile
+	// per tile of L1 length and chained edges share them. Boundary edges of open meshes are charged as
+	// well although a single triangle often covers their tiles, so this is an upper bound there
+	nedge_tiles = VL_MIN(ntiles, ceil(stats->outline_length / (vsize * VL_TRACE_TILE)));
+
+	// Masks live through the whole call, setup tables and bins only while tracing, points only after
+	mask_bytes  = npixels * sizeof(bool);
+	setup_bytes = 3.0 * stats->nfaces * (13 * sizeof(VL_Float) + sizeof(VL_Size)) + stats->noutline * 8 * sizeof(VL_Float) +
+				  (nbins + ntiles) * sizeof(VL_Size) + ntiles * sizeof(bool);
+	point_bytes = plan->est_points * sizeof(VL_Vector3F);
+	plan->peak_bytes = mask_bytes + VL_MAX(setup_bytes, point_bytes);
+	plan->max_peak_bytes = mask_bytes + VL_MAX(setup_bytes, plan->max_points * sizeof(VL_Vector3F));
+
+	// Binning primitives and outline edges, then every voxel of edge tiles tested against the average bin of a tile
+	plan->work = nbins + stats->noutline + nedge_tiles +
+				 nedge_tiles * VL_TRACE_TILE * VL_TRACE_TILE * VL_MAX(nbins / ntiles, 1.0) + plan->max_points;
+	return true;
+}
+
+
+/*
+ * Hit flags of three projection planes, voxel (x, y, z) is solid when it hits all of them
+ */
+typedef struct {
+	VL_Size     cx, cy, cz;
+	VL_Vector3F vmin;
+	bool *      front;
+	bool *      left;
+	bool *      top;
+} VL_ProjMasks;
+
+
+_VL_STATIC_ void vl_proj_masks_free(VL_ProjMasks * masks) {
+	free(masks->front);
+	free(masks->left);
+	free(masks->top);
+	masks->front = masks->left = masks->top = NULL;
+}
+
+
+/*
+ * Trace three projection planes of mesh
+ *
+ * Return:       false if mesh is empty, has an index out of range or memory allocation failed
+ * @masks:       Output projection masks, should be freed by vl_proj_masks_free
+ * @mesh:        Input mesh
+ * @vsize:       Input voxel size
+ */
+_VL_STATIC_ bool vl_proj_masks_from_mesh(
+	_VL_OUT_ VL_ProjMasks * const      masks,
+	_VL_IN_  const VL_MeshDesc * const mesh,
+	_VL_IN_  const VL_Float            vsize
+	) {
+	// Per axis triangle setup tables
+	VL_ProjSetup setup_front, setup_left, setup_top;
+	VL_Size * partners = NULL;
+	VL_Vector3F vmax;
+	VL_Size cx, cy, cz;
+	bool ok;
+
+	memset(masks, 0, sizeof(VL_ProjMasks));
+	memset(&setup_front, 0, sizeof(VL_ProjSetup));
+	memset(&setup_left, 0, sizeof(VL_ProjSetup));
+	memset(&setup_top, 0, sizeof(VL_ProjSetup));
+	if (!vl_mesh_desc_is_valid(mesh)) {
+		return false;
+	}
+
+	// Calculate voxel's bounding box and mash division in X, Y, Z direction
+	vl_mesh_desc_bbox(&masks->vmin, &vmax, mesh);
+	if (vl_is_grid_overflowed(&masks->vmin, &vmax, mesh->nfaces, vsize)) {
+		return false;
+	}
+	vl_point_cloud_res_from_bbox(&cx, &cy, &cz, &masks->vmin, &vmax, vsize);
+	masks->cx = cx;
+	masks->cy = cy;
+	masks->cz = cz;
+
+	// Allocate X, Y, Z project plane to store hit flag
+	masks->front = (bool *)malloc(sizeof(bool) * cx * cz);
+	masks->left  = (bool *)malloc(sizeof(bool) * cy * cz);
+	masks->top   = (bool *)malloc(sizeof(bool) * cx * cy);
+	if ((NULL == masks->front) || (NULL == masks->left) || (NULL == masks->top)) {
+		vl_proj_masks_free(masks);
+		return false;
+	}
+
+	// Build per axis triangle setup tables, this is where projection happens
+	if (!vl_mesh_desc_edge_partners(&partners, mesh) ||
+		!vl_proj_setup_build(&setup_front, VL_EProjectFront, mesh, partners, vsize) ||
+		!vl_proj_setup_build(&setup_left,  VL_EProjectLeft,  mesh, partners, vsize) ||
+		!vl_proj_setup_build(&setup_top,   VL_EProjectTop,   mesh, partners, vsize)) {
+		free(partners);
+		vl_proj_setup_free(&setup_front);
+		vl_proj_setup_free(&setup_left);
+		vl_proj_setup_free(&setup_top);
+		vl_proj_masks_free(masks);
+		return false;
+	}
+	free(partners);
+
+	// Trace Front, plane is (x, z), Left, plane is (-y, z) and Top, plane is (x, y)
+	ok = vl_proj_setup_trace(&setup_front, masks->front, cx, cz, masks->vmin.x, vsize, masks->vmin.z, vsize, NULL) &&
+		 vl_proj_setup_trace(&setup_left, masks->left, cy, cz, -masks->vmin.y, -vsize, masks->vmin.z, vsize, NULL) &&
+		 vl_proj_setup_trace(&setup_top, masks->top, cx, cy, masks->vmin.x, vsize, masks->vmin.y, vsize, NULL);
+
+	vl_proj_setup_free(&setup_front);
+	vl_proj_setup_free(&setup_left);
+	vl_proj_setup_free(&setup_top);
+	if (!ok) {
+		vl_proj_masks_free(masks);
+	}
+	return ok;
+}
+
+
+_VL_STATIC_ bool vl_proj_masks_hit(const VL_ProjMasks * const masks, const VL_Size x, const VL_Size y, const VL_Size z) {
+	return masks->front[z * masks->cx + x] && masks->left[z * masks->cy + y] && masks->top[y * masks->cx + x];
+}
+
+
+_VL_STATIC_ VL_Size vl_proj_masks_count(const VL_ProjMasks * const masks) {
+	VL_Size count = 0;
+	for (VL_Size x = 0; x < masks->cx; x++) {
+		for (VL_Size y = 0; y < masks->cy; y++) {
+			for (VL_Size z = 0; z < masks->cz; z++) {
+				if (vl_proj_masks_hit(masks, x, y, z)) {
+					count++;
+				}
+			}
+		}
+	}
+	return count;
+}
+
+
+/*
+ * Insert two zero bits between each of the lower 21 bits
+ */
+_VL_STATIC_ uint64_t vl_morton_spread(uint64_t v) {
+	v &= 0x1fffff;
+	v = (v | (v << 32)) & 0x1f00000000ffffULL;
+	v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+	v = (v | (v <<  8)) & 0x100f00f00f00f00fULL;
+	v = (v | (v <<  4)) & 0x10c30c30c30c30c3ULL;
+	v = (v | (v <<  2)) & 0x1249249249249249ULL;
+	return v;
+}
+
+
+_VL_STATIC_ uint64_t vl_morton_compact(uint64_t v) {
+	v &= 0x1249249249249249ULL;
+	v = (v | (v >>  2)) & 0x10c30c30c30c30c3ULL;
+	v = (v | (v >>  4)) & 0x100f00f00f00f00fULL;
+	v = (v | (v >>  8)) & 0x1f0000ff0000ffULL;
+	v = (v | (v >> 16)) & 0x1f00000000ffffULL;
+	v = (v | (v >> 32)) & 0x1fffff;
+	return v;
+}
+
+
+/*
+ * Summed area tables of projection masks, (w + 1) * (h + 1) each,
+ * so hit count of any rectangle on a projection plane is O(1)
+ */
+typedef struct {
+	VL_Size * front;
+	VL_Size * left;
+	VL_Size * top;
+} VL_ProjSums;
+
+
+_VL_STATIC_ void vl_proj_sums_free(VL_ProjSums * sums) {
+	free(sums->front);
+	free(sums->left);
+	free(sums->top);
+	sums->front = sums->left = sums->top = NULL;
+}
+
+
+_VL_STATIC_ void vl_sum_table_build(VL_Size * table, const bool * const mask, const VL_Size w, const VL_Size h) {
+	memset(table, 0, sizeof(VL_Size) * (w + 1));
+	for (VL_Size v = 0; v < h; v++) {
+		VL_Size row = 0;
+		table[(v + 1) * (w + 1)] = 0;
+		for (VL_Size u = 0; u < w; u++) {
+			row += mask[v * w + u] ? 1 : 0;
+			table[(v + 1) * (w + 1) + u + 1] = table[v * (w + 1) + u + 1] + row;
+		}
+	}
+}
+
+
+_VL_STATIC_ bool vl_proj_sums_build(VL_ProjSums * const sums, const VL_ProjMasks * const masks) {
+	sums->front = (VL_Size *)malloc(sizeof(VL_Size) * (masks->cx + 1) * (masks->cz + 1));
+	sums->left  = (VL_Size *)malloc(sizeof(VL_Size) * (masks->cy + 1) * (masks->cz + 1));
+	sums->top   = (VL_Size *)malloc(sizeof(VL_Size) * (masks->cx + 1) * (masks->cy + 1));
+	if ((NULL == sums->front) || (NULL == sums->left) || (NULL == sums->top)) {
+		vl_proj_sums_free(sums);
+		return false;
+	}
+	vl_sum_table_build(sums->front, masks->front, masks->cx, masks->cz);
+	vl_sum_table_build(sums->left,  masks->left,  masks->cy, masks->cz);
+	vl_sum_table_build(sums->top,   masks->top,   masks->cx, masks->cy);
+	return true;
+}
+
+
+/*
+ * Hit count of [u0, u1) * [v0, v1) on a projection plane of width w
+ */
+_VL_STATIC_ VL_Size vl_sum_table_rect(const VL_Size * const table, const VL_Size w, VL_Size u0, VL_Size u1, VL_Size v0, VL_Size v1) {
+	return table[v1 * (w + 1) + u1] - table[v0 * (w + 1) + u1] - table[v1 * (w + 1) + u0] + table[v0 * (w + 1) + u0];
+}
+
+
+typedef enum {
+	VL_ESvoEmpty,
+	VL_ESvoFull,
+	VL_ESvoMixed,
+} VL_SvoKind;
+
+
+/*
+ * Classify block of size s at (x0, y0, z0) exactly when it is full,
+ * empty when any projection of it has no hit, mixed otherwise until children tell
+ */
+_VL_STATIC_ VL_SvoKind vl_svo_classify(
+	_VL_IN_ const VL_ProjMasks * const masks,
+	_VL_IN_ const VL_ProjSums * const  sums,
+	_VL_IN_ const VL_Size x0, const VL_Size y0, const VL_Size z0, const VL_Size s
+	) {
+	VL_Size x1, y1, z1, nfront, nleft, ntop;
+	if ((x0 >= masks->cx) || (y0 >= masks->cy) || (z0 >= masks->cz)) {
+		return VL_ESvoEmpty;
+	}
+	x1 = VL_MIN(x0 + s, masks->cx);
+	y1 = VL_MIN(y0 + s, masks->cy);
+	z1 = VL_MIN(z0 + s, masks->cz);
+	nfront = vl_sum_table_rect(sums->front, masks->cx, x0, x1, z0, z1);
+	nleft  = vl_sum_table_rect(sums->left,  masks->cy, y0, y1, z0, z1);
+	ntop   = vl_sum_table_rect(sums->top,   masks->cx, x0, x1, y0, y1);
+	if ((nfront == 0) || (nleft == 0) || (ntop == 0)) {
+		return VL_ESvoEmpty;
+	}
+	// Block padded out of grid can never be full
+	if ((x1 - x0 == s) && (y1 - y0 == s) && (z1 - z0 == s) &&
+		(nfront == s * s) && (nleft == s * s) && (ntop == s * s)) {
+		return VL_ESvoFull;
+	}
+	return VL_ESvoMixed;
+}
+
+
+typedef struct {
+	VL_SvoNode * data;
+	uint32_t     n, cap;
+	bool         failed;
+} VL_SvoNodeArray;
+
+
+_VL_STATIC_ uint32_t vl_svo_node_push(VL_SvoNodeArray * const arr, const VL_SvoNode * const node) {
+	if (arr->failed) {
+		return 0;
+	}
+	if (arr->n == arr->cap) {
+		uint32_t cap = arr->cap ? arr->cap * 2 : 64;
+		VL_SvoNode * data = (arr->cap < UINT32_MAX / 2) ? (VL_SvoNode *)realloc(arr->data, sizeof(VL_SvoNode) * cap) : NULL;
+		if (NULL == data) {
+			arr->failed = true;
+			return 0;
+		}
+		arr->data = data;
+		arr->cap  = cap;
+	}
+	arr->data[arr->n] = *node;
+	return arr->n++;
+}
+
+
+/*
+ * Build subtree of block in post order, mixed children of a node are pushed contiguously right after their own subtrees
+ */
+_VL_STATIC_ VL_SvoKind vl_svo_build_block(
+	_VL_OUT_ VL_SvoNode * const        out_node,
+	_VL_OUT_ VL_SvoNodeArray * const   arr,
+	_VL_IN_  const VL_ProjMasks * const masks,
+	_VL_IN_  const VL_ProjSums * const  sums,
+	_VL_IN_  const VL_Size x0, const VL_Size y0, const VL_Size z0, const VL_Size s
+	) {
+	VL_SvoNode children[8];
+	VL_SvoKind kind = vl_svo_classify(masks, sums, x0, y0, z0, s);
+	VL_Size h = s / 2;
+
+	memset(out_node, 0, sizeof(VL_SvoNode));
+	if (kind != VL_ESvoMixed) {
+		return kind;
+	}
+	for (int i = 0; i < 8; i++) {
+		VL_SvoKind ckind = vl_svo_build_block(children + i, arr, masks, sums,
+				x0 + ((i & 1) ? h : 0), y0 + ((i & 2) ? h : 0), z0 + ((i & 4) ? h : 0), h);
+		if (ckind == VL_ESvoFull)  { out_node->full  |= (uint8_t)(1 << i); }
+		if (ckind == VL_ESvoMixed) { out_node->mixed |= (uint8_t)(1 << i); }
+	}
+	// Collapse block whose children are all empty
+	if ((out_node->mixed == 0) && (out_node->full == 0)) {
+		return VL_ESvoEmpty;
+	}
+	out_node->child = arr->n;
+	for (int i = 0; i < 8; i++) {
+		if (out_node->mixed & (1 << i)) {
+			vl_svo_node_push(arr, children + i);
+		}
+	}
+	return VL_ESvoMixed;
+}
+
+
+/*
+ * Link upper levels above parallel subtrees, subtree results are already relocated into arr
+ */
+_VL_STATIC_ VL_SvoKind vl_svo_link_block(
+	_VL_OUT_ VL_SvoNode * const        out_node,
+	_VL_OUT_ VL_SvoNodeArray * const   arr,
+	_VL_IN_  const VL_SvoKind * const  task_kinds,
+	_VL_IN_  const VL_SvoNode * const  task_nodes,
+	_VL_IN_  const VL_Size             ntasks_axis,
+	_VL_IN_  const VL_Size bx, const VL_Size by, const VL_Size bz, const VL_Size s
+	) {
+	VL_SvoNode children[8];
+	VL_Size h = s / 2;
+
+	memset(out_node, 0, sizeof(VL_SvoNode));
+	if (s == 1) {
+		VL_Size t = (bz * ntasks_axis + by) * ntasks_axis + bx;
+		*out_node = task_nodes[t];
+		return task_kinds[t];
+	}
+	for (int i = 0; i < 8; i++) {
+		VL_SvoKind ckind = vl_svo_link_block(children + i, arr, task_kinds, task_nodes, ntasks_axis,
+				bx + ((i & 1) ? h : 0), by + ((i & 2) ? h : 0), bz + ((i & 4) ? h : 0), h);
+		if (ckind == VL_ESvoFull)  { out_node->full  |= (uint8_t)(1 << i); }
+		if (ckind == VL_ESvoMixed) { out_node->mixed |= (uint8_t)(1 << i); }
+	}
+	if ((out_node->mixed == 0) && (out_node->full == 0)) {
+		return VL_ESvoEmpty;
+	}
+	if ((out_node->mixed == 0) && (out_node->full == 0xff)) {
+		return VL_ESvoFull;
+	}
+	out_node->child = arr->n;
+	for (int i = 0; i < 8; i++) {
+		if (out_node->mixed & (1 << i)) {
+			vl_svo_node_push(arr, children + i);
+		}
+	}
+	return VL_ESvoMixed;
+}
+
+
+_VL_STATIC_ bool vl_svo_raycast_node(
+	_VL_IN_  const VL_Svo * const svo,
+	_VL_IN_  uint32_t             node_index,
+	_VL_IN_  const VL_Size x0, const VL_Size y0, const VL_Size z0, const VL_Size s,
+	_VL_IN_  const VL_Float * const origin,
+	_VL_IN_  const VL_Float * const inv_dir,
+	_VL_IN_  VL_Float             tmin,
+	_VL_IN_  VL_Float             tmax,
+	_VL_OUT_ VL_Float * const     out_t
+	);
+
+
+/*
+ * Slab test of block of size s at (x0, y0, z0) in voxel units
+ */
+_VL_STATIC_ bool vl_svo_ray_block(
+	_VL_OUT_ VL_Float * const out_t0,
+	_VL_OUT_ VL_Float * const out_t1,
+	_VL_IN_  const VL_Size x0, const VL_Size y0, const VL_Size z0, const VL_Size s,
+	_VL_IN_  const VL_Float * const origin,
+	_VL_IN_  const VL_Float * const inv_dir,
+	_VL_IN_  const VL_Float tmin,
+	_VL_IN_  const VL_Float tmax
+	) {
+	const VL_Float lo[3] = { (VL_Float)x0, (VL_Float)y0, (VL_Float)z0 };
+	VL_Float t0 = tmin, t1 = tmax;
+	for (int a = 0; a < 3; a++) {
+		VL_Float ta = (lo[a] - origin[a]) * inv_dir[a];
+		VL_Float tb = (lo[a] + s - origin[a]) * inv_dir[a];
+		// Ray parallel to slab and outside of it gives nan
+		if (ta != ta || tb != tb) {
+			if ((origin[a] < lo[a]) || (origin[a] > lo[a] + s)) {
+				return false;
+			}
+			continue;
+		}
+		t0 = VL_MAX(t0, VL_MIN(ta, tb));
+		t1 = VL_MIN(t1, VL_MAX(ta, tb));
+	}
+	*out_t0 = t0;
+	*out_t1 = t1;
+	return t0 <= t1;
+}
+
+
+_VL_STATIC_ bool vl_svo_raycast_node(
+	_VL_IN_  const VL_Svo * const svo,
+	_VL_IN_  uint32_t             node_index,
+	_VL_IN_  const VL_Size x0, const VL_Size y0, const VL_Size z0, const VL_Size s,
+	_VL_IN_  const VL_Float * const origin,
+	_VL_IN_  const VL_Float * const inv_dir,
+	_VL_IN_  VL_Float             tmin,
+	_VL_IN_  VL_Float             tmax,
+	_VL_OUT_ VL_Float * const     out_t
+	) {
+	const VL_SvoNode * node = svo->nodes + node_index;
+	VL_Size h = s / 2;
+	int order[8], norder = 0;
+	VL_Float entry[8], exit[8];
+
+	// Visit non empty children front to back
+	for (int i = 0; i < 8; i++) {
+		VL_Float t0, t1;
+		if (!((node->mixed | node->full) & (1 << i))) {
+			continue;
+		}
+		if (!vl_svo_ray_block(&t0, &t1, x0 + ((i & 1) ? h : 0), y0 + ((i & 2) ? h : 0), z0 + ((i & 4) ? h : 0), h,
+					origin, inv_dir, tmin, tmax)) {
+			continue;
+		}
+		int k = norder++;
+		while ((k > 0) && (entry[order[k - 1]] > t0)) {
+			order[k] = order[k - 1];
+			k--;
+		}
+		order[k] = i;
+		entry[i] = t0;
+		exit[i]  = t1;
+	}
+	for (int k = 0; k < norder; k++) {
+		int i = order[k];
+		if (node->full & (1 << i)) {
+			*out_t = entry[i];
+			return true;
+		}
+		uint32_t child = node->child;
+		for (int j = 0; j < i; j++) {
+			if (node->mixed & (1 << j)) { child++; }
+		}
+		if (vl_svo_raycast_node(svo, child, x0 + ((i & 1) ? h : 0), y0 + ((i & 2) ? h : 0), z0 + ((i & 4) ? h : 0), h,
+					origin, inv_dir, entry[i], exit[i], out_t)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/*
+ * Voxel cube corners in unit of half voxel, same as vl_mesh_from_point_cloud,
+ * and its triangles wound counter clockwise seen from outside with their normals
+ */
+static const int vl_cube_corners[8][3] = {
+	{ 1, -1,  1 }, { -1, -1,  1 }, { 1,  1,  1 }, { -1,  1,  1 },
+	{ 1, -1, -1 }, { -1, -1, -1 }, { 1,  1, -1 }, { -1,  1, -1 },
+};
+static const int vl_cube_tris[12][3] = {
+	{ 0, 2, 1 }, { 1, 2, 3 }, { 4, 5, 6 }, { 5, 7, 6 },
+	{ 0, 1, 4 }, { 1, 5, 4 }, { 2, 6, 3 }, { 3, 6, 7 },
+	{ 1, 3, 5 }, { 3, 7, 5 }, { 0, 4, 2 }, { 2, 4, 6 },
+};
+static const int vl_cube_normals[12][3] = {
+	{ 0, 0,  1 }, { 0, 0,  1 }, { 0, 0, -1 }, { 0, 0, -1 },
+	{ 0, -1, 0 }, { 0, -1, 0 }, { 0,  1, 0 }, { 0,  1, 0 },
+	{ -1, 0, 0 }, { -1, 0, 0 }, { 1,  0, 0 }, { 1,  0, 0 },
+};
+
+
+#define VL_WRITER_BUFLEN 65536
+
+
+/*
+ * Fixed size output buffer flushed to file descriptor
+ */
+typedef struct {
+	int    fd;
+	size_t n;
+	bool   failed;
+	char * buf;
+} VL_FdWriter;
+
+
+/*
+ * Write all n bytes, retrying short and interrupted writes
+ */
+_VL_STATIC_ bool vl_fd_write_all(const int fd, const void * const data, size_t n) {
+	const char * p = (const char *)data;
+	while (n > 0) {
+		long r = (long)vl_fd_write(fd, p, VL_MIN(n, (size_t)1 << 30));
+		if (r < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		p += r;
+		n -= (size_t)r;
+	}
+	return true;
+}
+
+
+_VL_STATIC_ void vl_writer_flush(VL_FdWriter * const w) {
+	if (!w->failed && !vl_fd_write_all(w->fd, w->buf, w->n)) {
+		w->failed = true;
+	}
+	w->n = 0;
+}
+
+
+/*
+ * Reserve len bytes in buffer, len should not exceed VL_WRITER_BUFLEN
+ */
+_VL_STATIC_ char * vl_writer_reserve(VL_FdWriter * const w, const size_t len) {
+	if (w->n + len > VL_WRITER_BUFLEN) {
+		vl_writer_flush(w);
+	}
+	return w->buf + w->n;
+}
+
+
+_VL_STATIC_ void vl_writer_put(VL_FdWriter * const w, const void * const data, const size_t len) {
+	memcpy(vl_writer_reserve(w, len), data, len);
+	w->n += len;
+}
+
+
+_VL_STATIC_ void vl_writer_put_u32le(VL_FdWriter * const w, const uint32_t v) {
+	unsigned char * p = (unsigned char *)vl_writer_reserve(w, 4);
+	p[0] = (unsigned char)(v);
+	p[1] = (unsigned char)(v >> 8);
+	p[2] = (unsigned char)(v >> 16);
+	p[3] = (unsigned char)(v >> 24);
+	w->n += 4;
+}
+
+
+_VL_STATIC_ void vl_writer_put_f32le(VL_FdWriter * const w, const float v) {
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	vl_writer_put_u32le(w, bits);
+}
+
+
+/*
+ * Format v as "%.6f" does for |v| < 1e15 and as "%.17g" beyond, writes at most VL_FORMAT_FLOAT_MAX chars
+ * Values below 1e7 are scaled to integers directly, as their product with 1e6 is off by less than 0.002,
+ * so only values that close to halfway between two outputs need printf to round them
+ */
+#define VL_FORMAT_FLOAT_MAX 31
+
+
+_VL_STATIC_ char * vl_format_float(char * p, const double v) {
+	char digits[24];
+	double x = fabs(v) * 1e6;
+	uint64_t scaled, ipart, fpart;
+	int n = 0;
+
+	if (!(fabs(v) < 1e7) || (fabs(x - floor(x) - 0.5) < 0.004)) {
+		n = snprintf(p, VL_FORMAT_FLOAT_MAX + 1, fabs(v) < 1e15 ? "%.6f" : "%.17g", v);
+		return p + VL_MAX(VL_MIN(n, VL_FORMAT_FLOAT_MAX), 0);
+	}
+	scaled = (uint64_t)(x + 0.5);
+	ipart = scaled / 1000000;
+	fpart = scaled % 1000000;
+	if (signbit(v)) {
+		*p++ = '-';
+	}
+	do {
+		digits[n++] = (char)('0' + ipart % 10);
+		ipart /= 10;
+	} while (ipart > 0);
+	while (n > 0) {
+		*p++ = digits[--n];
+	}
+	*p++ = '.';
+	for (int i = 5; i >= 0; i--) {
+		p[i] = (char)('0' + fpart % 10);
+		fpart /= 10;
+	}
+	return p + 6;
+}
+
+
+_VL_STATIC_ char * vl_format_uint(char * p, uint64_t v) {
+	char digits[24];
+	int n = 0;
+	do {
+		digits[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v > 0);
+	while (n > 0) {
+		*p++ = digits[--n];
+	}
+	return p;
+}
+
+
+_VL_STATIC_ void vl_write_obj(VL_FdWriter * const w, const VL_Vector3F * const points, const VL_Size npoints, const VL_Float halfsize) {
+	static const char head[] = "o Voxel\n";
+	static const char smooth[] = "s off\n";
+
+	vl_writer_put(w, head, sizeof(head) - 1);
+	for (VL_Size i = 0; (i < npoints) && !w->failed; i++) {
+		for (int k = 0; k < 8; k++) {
+			char * p = vl_writer_reserve(w, 3 * (VL_FORMAT_FLOAT_MAX + 1) + 2), * q = p;
+			*q++ = 'v';
+			*q++ = ' '; q = vl_format_float(q, points[i].x + vl_cube_corners[k][0] * halfsize);
+			*q++ = ' '; q = vl_format_float(q, points[i].y + vl_cube_corners[k][1] * halfsize);
+			*q++ = ' '; q = vl_format_float(q, points[i].z + vl_cube_corners[k][2] * halfsize);
+			*q++ = '\n';
+			w->n += (size_t)(q - p);
+		}
+	}
+	vl_writer_put(w, smooth, sizeof(smooth) - 1);
+	for (VL_Size i = 0; (i < npoints) && !w->failed; i++) {
+		for (int k = 0; k < 12; k++) {
+			char * p = vl_writer_reserve(w, 80), * q = p;
+			*q++ = 'f';
+			for (int j = 0; j < 3; j++) {
+				*q++ = ' ';
+				q = vl_format_uint(q, (uint64_t)i * 8 + vl_cube_tris[k][j] + 1);
+			}
+			*q++ = '\n';
+			w->n += (size_t)(q - p);
+		}
+	}
+}
+
+
+_VL_STATIC_ bool vl_write_ply(VL_FdWriter * const w, const VL_Vector3F * const points, const VL_Size npoints, const VL_Float halfsize) {
+	char head[256];
+	int len;
+
+	// Vertex indices are stored as uint
+	if ((uint64_t)npoints * 8 > UINT32_MAX) {
+		return false;
+	}
+	len = snprintf(head, sizeof(head),
+			"ply\n"
+			"format binary_little_endian 1.0\n"
+			"element vertex %lu\n"
+			"property float x\n"
+			"property float y\n"
+			"property float z\n"
+			"element face %lu\n"
+			"property list uchar uint vertex_indices\n"
+			"end_header\n",
+			(unsigned long)npoints * 8, (unsigned long)npoints * 12);
+	vl_writer_put(w, head, (size_t)len);
+	for (VL_Size i = 0; (i < npoints) && !w->failed; i++) {
+		for (int k = 0; k < 8; k++) {
+			vl_writer_put_f32le(w, (float)(points[i].x + vl_cube_corners[k][0] * halfsize));
+			vl_writer_put_f32le(w, (float)(points[i].y + vl_cube_corners[k][1] * halfsize));
+			vl_writer_put_f32le(w, (float)(points[i].z + vl_cube_corners[k][2] * halfsize));
+		}
+	}
+	for (VL_Size i = 0; (i < npoints) && !w->failed; i++) {
+		for (int k = 0; k < 12; k++) {
+			const unsigned char count = 3;
+			vl_writer_put(w, &count, 1);
+			for (int j = 0; j < 3; j++) {
+				vl_writer_put_u32le(w, (uint32_t)(i * 8 + vl_cube_tris[k][j]));
+			}
+		}
+	}
+	return true;
+}
+
+
+_VL_STATIC_ bool vl_write_stl(VL_FdWriter * const w, const VL_Vector3F * const points, const VL_Size npoints, const VL_Float halfsize) {
+	char head[80];
+	const unsigned char attr[2] = { 0, 0 };
+
+	// Triangle count is stored as uint32
+	if ((uint64_t)npoints * 12 > UINT32_MAX) {
+		return false;
+	}
+	memset(head, 0, sizeof(head));
+	strcpy(head, "Voxel");
+	vl_writer_put(w, head, sizeof(head));
+	vl_writer_put_u32le(w, (uint32_t)(npoints * 12));
+	for (VL_Size i = 0; (i < npoints) && !w->failed; i++) {
+		for (int k = 0; k < 12; k++) {
+			vl_writer_put_f32le(w, (float)vl_cube_normals[k][0]);
+			vl_writer_put_f32le(w, (float)vl_cube_normals[k][1]);
+			vl_writer_put_f32le(w, (float)vl_cube_normals[k][2]);
+			for (int j = 0; j < 3; j++) {
+				const int * corner = vl_cube_corners[vl_cube_tris[k][j]];
+				vl_writer_put_f32le(w, (float)(points[i].x + corner[0] * halfsize));
+				vl_writer_put_f32le(w, (float)(points[i].y + corner[1] * halfsize));
+				vl_writer_put_f32le(w, (float)(points[i].z + corner[2] * halfsize));
+			}
+			vl_writer_put(w, attr, sizeof(attr));
+		}
+	}
+	return true;
+}
+
+
+_VL_STATIC_ int vl_popcount64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(v);
+#else
+	v = v - ((v >> 1) & 0x5555555555555555ULL);
+	v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+	v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
+_VL_STATIC_ int vl_ctz64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(v);
+#else
+	int n = 0;
+	while (!(v & 1)) { v >>= 1; n++; }
+	return n;
+#endif
+}
+
+
+/*
+ * Words of 64 voxels per row of a grid cx voxels wide
+ */
+_VL_STATIC_ VL_Size vl_grid_row_words(const VL_Size cx) {
+	return (cx + 63) / 64;
+}
+
+
+_VL_STATIC_ uint64_t * vl_grid_row(const VL_VoxelGrid * const grid, const VL_Size y, const VL_Size z) {
+	return grid->bits + (z * grid->header.cy + y) * grid->nwords;
+}
+
+
+/*
+ * Allocate zeroed grid of header, header dims may be 0 for an empty grid
+ */
+_VL_STATIC_ bool vl_grid_alloc(VL_VoxelGrid * const grid, const VL_VoxelHeader * const header) {
+	double nwords = (double)vl_grid_row_words(header->cx) * header->cy * header->cz;
+	memset(grid, 0, sizeof(VL_VoxelGrid));
+	if ((nwords >= (double)(VL_Size)-1) || (nwords * sizeof(uint64_t) >= (double)SIZE_MAX)) {
+		return false;
+	}
+	grid->header = *header;
+	grid->nwords = vl_grid_row_words(header->cx);
+	grid->bits   = (uint64_t *)calloc((size_t)nwords + 1, sizeof(uint64_t));
+	return NULL != grid->bits;
+}
+
+
+/*
+ * Pack a projection plane of w * h flags into rows of 64 bit words
+ */
+_VL_STATIC_ uint64_t * vl_mask_pack(const bool * const mask, const VL_Size w, const VL_Size h) {
+	const VL_Size nwords = vl_grid_row_words(w);
+	uint64_t * bits = (uint64_t *)calloc(nwords * h + 1, sizeof(uint64_t));
+	if (NULL == bits) {
+		return NULL;
+	}
+	for (VL_Size v = 0; v < h; v++) {
+		for (VL_Size u = 0; u < w; u++) {
+			if (mask[v * w + u]) {
+				bits[v * nwords + u / 64] |= (uint64_t)1 << (u % 64);
+			}
+		}
+	}
+	return bits;
+}
+
+
+/*
+ * Solid voxels of masks as grid, row (y, z) is packed front row z AND packed top row y when left (y, z) hits
+ */
+_VL_STATIC_ bool vl_grid_from_masks(VL_VoxelGrid * const grid, const VL_ProjMasks * const masks, const VL_Float vsize) {
+	VL_VoxelHeader header;
+	uint64_t * front, * top;
+
+	header.origin = masks->vmin;
+	header.vsize  = vsize;
+	header.cx     = masks->cx;
+	header.cy     = masks->cy;
+	header.cz     = masks->cz;
+	if (!vl_grid_alloc(grid, &header)) {
+		return false;
+	}
+	front = vl_mask_pack(masks->front, masks->cx, masks->cz);
+	top   = vl_mask_pack(masks->top,   masks->cx, masks->cy);
+	if ((NULL == front) || (NULL == top)) {
+		free(front);
+		free(top);
+		vl_grid_free(grid);
+		return false;
+	}
+	#pragma omp parallel for schedule(static)
+	for (long z = 0; z < (long)masks->cz; z++) {
+		for (VL_Size y = 0; y < masks->cy; y++) {
+			uint64_t * row = vl_grid_row(grid, y, (VL_Size)z);
+			const uint64_t * frow = front + (VL_Size)z * grid->nwords;
+			const uint64_t * trow = top + y * grid->nwords;
+			if (!masks->left[(VL_Size)z * masks->cy + y]) {
+				continue;
+			}
+			for (VL_Size w = 0; w < grid->nwords; w++) {
+				row[w] = frow[w] & trow[w];
+			}
+		}
+	}
+	free(front);
+	free(top);
+	return true;
+}
+
+
+/*
+ * out(x) = src(x + x0) for x in [0, 64 * nwords), src of nsrc words, bits out of src read as empty
+ */
+_VL_STATIC_ void vl_grid_row_shift(
+	_VL_OUT_ uint64_t * const       out,
+	_VL_IN_  const uint64_t * const src,
+	_VL_IN_  const VL_Size          nsrc,
+	_VL_IN_  const long long        x0,
+	_VL_IN_  const VL_Size          nwords
+	) {
+	// Floor division, so negative starts shift in zeros from the left
+	const long long w0 = x0 >= 0 ? x0 / 64 : -((-x0 + 63) / 64);
+	const int shift = (int)(x0 - w0 * 64);
+	for (VL_Size k = 0; k < nwords; k++) {
+		long long w = w0 + (long long)k;
+		uint64_t lo = ((w >= 0) && (w < (long long)nsrc)) ? src[w] : 0;
+		uint64_t hi = ((w + 1 >= 0) && (w + 1 < (long long)nsrc)) ? src[w + 1] : 0;
+		out[k] = shift ? ((lo >> shift) | (hi << (64 - shift))) : lo;
+	}
+}
+
+
+/*
+ * Extract nwords words of row (y, z) starting at voxel x0, voxels out of grid read as empty
+ * y, z and x0 are signed so callers can address rows of another grid through an offset
+ */
+_VL_STATIC_ void vl_grid_row_extract(
+	_VL_OUT_ uint64_t * const           out,
+	_VL_IN_  const VL_VoxelGrid * const grid,
+	_VL_IN_  const long long            x0,
+	_VL_IN_  const long long            y,
+	_VL_IN_  const long long            z,
+	_VL_IN_  const VL_Size              nwords
+	) {
+	if ((y < 0) || (z < 0) || (y >= (long long)grid->header.cy) || (z >= (long long)grid->header.cz)) {
+		memset(out, 0, sizeof(uint64_t) * nwords);
+		return;
+	}
+	vl_grid_row_shift(out, vl_grid_row(grid, (VL_Size)y, (VL_Size)z), grid->nwords, x0, nwords);
+}
+
+
+/*
+ * Combine rows word by word, plain loops so the compiler can vectorize them
+ */
+_VL_STATIC_ void vl_grid_row_combine(uint64_t * const a, const uint64_t * const b, const VL_Size nwords, const VL_BoolOp op) {
+	switch (op) {
+		case VL_EBoolUnion:        for (VL_Size k = 0; k < nwords; k++) { a[k] |= b[k];  } break;
+		case VL_EBoolIntersection: for (VL_Size k = 0; k < nwords; k++) { a[k] &= b[k];  } break;
+		case VL_EBoolDifference:   for (VL_Size k = 0; k < nwords; k++) { a[k] &= ~b[k]; } break;
+		case VL_EBoolXor:          for (VL_Size k = 0; k < nwords; k++) { a[k] ^= b[k];  } break;
+	}
+}
+
+
+/*
+ * Frame of boolean result in voxel lattice of a, lo is inclusive and hi exclusive
+ *
+ * Return:       false if voxel sizes differ
+ */
+_VL_STATIC_ bool vl_grid_boolean_frame(
+	_VL_OUT_ long long * const          lo,
+	_VL_OUT_ long long * const          hi,
+	_VL_OUT_ long long * const          offset,
+	_VL_IN_  const VL_VoxelGrid * const a,
+	_VL_IN_  const VL_VoxelGrid * const b,
+	_VL_IN_  const VL_BoolOp            op
+	) {
+	const VL_Float vsize = a->header.vsize;
+	const VL_Float origin_a[3] = { a->header.origin.x, a->header.origin.y, a->header.origin.z };
+	const VL_Float origin_b[3] = { b->header.origin.x, b->header.origin.y, b->header.origin.z };
+	const VL_Size dims_a[3] = { a->header.cx, a->header.cy, a->header.cz };
+	const VL_Size dims_b[3] = { b->header.cx, b->header.cy, b->header.cz };
+
+	if (fabs(a->header.vsize - b->header.vsize) > 1e-6 * vsize) {
+		return false;
+	}
+	for (int i = 0; i < 3; i++) {
+		// Origin of b snapped to the nearest voxel of a
+		offset[i] = (long long)floor((origin_b[i] - origin_a[i]) / vsize + 0.5);
+		switch (op) {
+			case VL_EBoolUnion:
+			case VL_EBoolXor:
+				lo[i] = VL_MIN(0, offset[i]);
+				hi[i] = VL_MAX((long long)dims_a[i], offset[i] + (long long)dims_b[i]);
+				break;
+			case VL_EBoolIntersection:
+				lo[i] = VL_MAX(0, offset[i]);
+				hi[i] = VL_MIN((long long)dims_a[i], offset[i] + (long long)dims_b[i]);
+				break;
+			case VL_EBoolDifference:
+				lo[i] = 0;
+				hi[i] = (long long)dims_a[i];
+				break;
+		}
+		hi[i] = VL_MAX(hi[i], lo[i]);
+	}
+	return true;
+}
+
+
+/*
+ * Runs of hits along v of every column u of a projection plane of w * h flags
+ * Runs of column u are runs[2 * offsets[u]] to runs[2 * offsets[u + 1]], each as [begin, end)
+ *
+ * Return:       false if memory allocation failed
+ */
+_VL_STATIC_ bool vl_mask_column_runs(
+	_VL_OUT_ VL_Size ** const   out_offsets,
+	_VL_OUT_ VL_Size ** const   out_runs,
+	_VL_IN_  const bool * const mask,
+	_VL_IN_  const VL_Size      w,
+	_VL_IN_  const VL_Size      h
+	) {
+	VL_Size * offsets = (VL_Size *)malloc(sizeof(VL_Size) * (w + 1));
+	VL_Size * runs;
+	VL_Size nruns = 0;
+
+	*out_offsets = NULL;
+	*out_runs = NULL;
+	if (NULL == offsets) {
+		return false;
+	}
+	for (VL_Size u = 0; u < w; u++) {
+		offsets[u] = nruns;
+		for (VL_Size v = 0; v < h; v++) {
+			if (mask[v * w + u] && ((v == 0) || !mask[(v - 1) * w + u])) {
+				nruns++;
+			}
+		}
+	}
+	offsets[w] = nruns;
+	runs = (VL_Size *)malloc(sizeof(VL_Size) * (nruns * 2 + 1));
+	if (NULL == runs) {
+		free(offsets);
+		return false;
+	}
+	for (VL_Size u = 0, r = 0; u < w; u++) {
+		for (VL_Size v = 0; v < h; v++) {
+			if (mask[v * w + u] && ((v == 0) || !mask[(v - 1) * w + u])) {
+				runs[r * 2] = v;
+			}
+			if (mask[v * w + u] && ((v + 1 == h) || !mask[(v + 1) * w + u])) {
+				runs[r * 2 + 1] = v + 1;
+				r++;
+			}
+		}
+	}
+	*out_offsets = offsets;
+	*out_runs = runs;
+	return true;
+}
+
+
+/*
+ * Sum of i and i^2 for i in [a, b)
+ */
+_VL_STATIC_ void vl_run_sums(double * const s1, double * const s2, const double a, const double b) {
+	*s1 = (a + b - 1.0) * (b - a) / 2.0;
+	*s2 = ((b - 1.0) * b * (2.0 * b - 1.0) - (a - 1.0) * a * (2.0 * a - 1.0)) / 6.0;
+}
+
+
+/*
+ * Mass properties of solid voxels of masks, voxels are intersected column by column as runs along z
+ */
+_VL_STATIC_ bool vl_mass_properties_from_masks(
+	_VL_OUT_ VL_MassProperties * const  props,
+	_VL_IN_  const VL_ProjMasks * const masks,
+	_VL_IN_  const VL_Float             vsize
+	) {
+	VL_Size * front_offsets, * front_runs, * left_offsets, * left_runs;
+	// Moments in voxel units, relative to grid center to keep sums small
+	const double mx = masks->cx / 2.0, my = masks->cy / 2.0, mz = masks->cz / 2.0;
+	double n = 0, sx = 0, sy = 0, sz = 0, sxx = 0, syy = 0, szz = 0, sxy = 0, sxz = 0, syz = 0;
+	double h, mass, cxx, cyy, czz, cxy, cxz, cyz;
+
+	memset(props, 0, sizeof(VL_MassProperties));
+	if (!vl_mask_column_runs(&front_offsets, &front_runs, masks->front, masks->cx, masks->cz)) {
+		return false;
+	}
+	if (!vl_mask_column_runs(&left_offsets, &left_runs, masks->left, masks->cy, masks->cz)) {
+		free(front_offsets);
+		free(front_runs);
+		return false;
+	}
+
+	#pragma omp parallel for schedule(dynamic) reduction(+:n, sx, sy, sz, sxx, syy, szz, sxy, sxz, syz)
+	for (long x = 0; x < (long)masks->cx; x++) {
+		const double px = x + 0.5 - mx;
+		for (VL_Size y = 0; y < masks->cy; y++) {
+			const double py = y + 0.5 - my;
+			VL_Size i, iend, j, jend;
+			if (!masks->top[y * masks->cx + (VL_Size)x]) {
+				continue;
+			}
+			// Merge z runs of front column x and left column y
+			i = front_offsets[x]; iend = front_offsets[x + 1];
+			j = left_offsets[y];  jend = left_offsets[y + 1];
+			while ((i < iend) && (j < jend)) {
+				VL_Size z0 = VL_MAX(front_runs[i * 2], left_runs[j * 2]);
+				VL_Size z1 = VL_MIN(front_runs[i * 2 + 1], left_runs[j * 2 + 1]);
+				if (z0 < z1) {
+					double cnt = (double)(z1 - z0), s1, s2;
+					// Sums of (z + 0.5 - mz) and its square over the run
+					vl_run_sums(&s1, &s2, (double)z0, (double)z1);
+					s2 = s2 + 2.0 * (0.5 - mz) * s1 + cnt * (0.5 - mz) * (0.5 - mz);
+					s1 = s1 + cnt * (0.5 - mz);
+					n   += cnt;
+					sx  += cnt * px;
+					sy  += cnt * py;
+					sz  += s1;
+					sxx += cnt * px * px;
+					syy += cnt * py * py;
+					szz += s2;
+					sxy += cnt * px * py;
+					sxz += px * s1;
+					syz += py * s1;
+				}
+				if (front_runs[i * 2 + 1] < left_runs[j * 2 + 1]) {
+					i++;
+				} else {
+					j++;
+				}
+			}
+		}
+	}
+	free(front_offsets);
+	free(front_runs);
+	free(left_offsets);
+	free(left_runs);
+
+	props->nvoxels = (VL_Size)n;
+	if (n == 0) {
+		return true;
+	}
+	h = vsize;
+	mass = n * h * h * h;
+	props->volume = mass;
+	props->centroid.x = masks->vmin.x + (mx + sx / n) * h;
+	props->centroid.y = masks->vmin.y + (my + sy / n) * h;
+	props->centroid.z = masks->vmin.z + (mz + sz / n) * h;
+	// Central second moments, each voxel also adds inertia of a cube about its own center
+	cxx = (sxx / n - (sx / n) * (sx / n)) * h * h;
+	cyy = (syy / n - (sy / n) * (sy / n)) * h * h;
+	czz = (szz / n - (sz / n) * (sz / n)) * h * h;
+	cxy = (sxy / n - (sx / n) * (sy / n)) * h * h;
+	cxz = (sxz / n - (sx / n) * (sz / n)) * h * h;
+	cyz = (syz / n - (sy / n) * (sz / n)) * h * h;
+	props->inertia[0][0] = mass * (cyy + czz + h * h / 6.0);
+	props->inertia[1][1] = mass * (cxx + czz + h * h / 6.0);
+	props->inertia[2][2] = mass * (cxx + cyy + h * h / 6.0);
+	props->inertia[0][1] = props->inertia[1][0] = -mass * cxy;
+	props->inertia[0][2] = props->inertia[2][0] = -mass * cxz;
+	props->inertia[1][2] = props->inertia[2][1] = -mass * cyz;
+	return true;
+}
+
+
+/*
+ * Lower bound of key in ascending keys
+ */
+_VL_STATIC_ VL_Size vl_lower_bound_u64(const uint64_t * const keys, const VL_Size n, const uint64_t key) {
+	VL_Size lo = 0, hi = n;
+	while (lo < hi) {
+		VL_Size mid = lo + (hi - lo) / 2;
+		if (keys[mid] < key) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+
+/*
+ * Quantize point into 21 bits per axis cells of size 1 / inv_cell from vmin, clamped at both ends
+ */
+_VL_STATIC_ void vl_weld_cell(uint64_t out[3], const VL_Vector3F * const v, const VL_Vector3F * const vmin, const VL_Float inv_cell) {
+	const VL_Float c[3] = { (v->x - vmin->x) * inv_cell, (v->y - vmin->y) * inv_cell, (v->z - vmin->z) * inv_cell };
+	for (int k = 0; k < 3; k++) {
+		out[k] = c[k] <= 0 ? 0 : c[k] >= (VL_Float)0x1fffff ? 0x1fffff : (uint64_t)c[k];
+	}
+}
+
+
+/*
+ * Weld vertices closer than tol through spatial hash of sorted cell keys
+ * Every vertex first finds smallest index within tol in its 27 neighbouring cells in parallel,
+ * then remap resolves those links in index order, so clusters chain to their smallest index
+ *
+ * Return:       false if memory allocation failed
+ * @remap:       Output index of vertex each vertex is welded to, its own index if kept
+ */
+_VL_STATIC_ bool vl_weld_vertices(
+	_VL_OUT_ VL_Size * const           remap,
+	_VL_IN_  const VL_Vector3F * const verts,
+	_VL_IN_  const VL_Size             nverts,
+	_VL_IN_  const VL_Vector3F * const vmin,
+	_VL_IN_  const VL_Vector3F * const vmax,
+	_VL_IN_  const VL_Float            tol
+	) {
+	const VL_Float extent = VL_MAX(VL_MAX(vmax->x - vmin->x, vmax->y - vmin->y), vmax->z - vmin->z);
+	// Cells never drop below 1 / 2^21 of extent, smaller ones would all clamp into the last cell.
+	// They are never smaller than tol either, so vertices within tol are at most one cell apart
+	const VL_Float cell = VL_MAX(tol, extent / (VL_Float)0x1fffff) > 0 ? VL_MAX(tol, extent / (VL_Float)0x1fffff) : (VL_Float)1;
+	const VL_Float tol2 = tol > 0 ? tol * tol : 0;
+	uint64_t * keys = (uint64_t *)malloc(sizeof(uint64_t) * nverts);
+	VL_Size * order = (VL_Size *)malloc(sizeof(VL_Size) * nverts);
+
+	if ((NULL == keys) || (NULL == order)) {
+		free(keys);
+		free(order);
+		return false;
+	}
+	#pragma omp parallel for
+	for (long i = 0; i < (long)nverts; i++) {
+		uint64_t c[3];
+		vl_weld_cell(c, verts + i, vmin, 1 / cell);
+		keys[i] = vl_morton_spread(c[0]) | (vl_morton_spread(c[1]) << 1) | (vl_morton_spread(c[2]) << 2);
+		order[i] = (VL_Size)i;
+	}
+	if (!vl_radix_sort_u64(keys, order, nverts, 63)) {
+		free(keys);
+		free(order);
+		return false;
+	}
+
+	#pragma omp parallel for schedule(dynamic, 256)
+	for (long i = 0; i < (long)nverts; i++) {
+		const VL_Vector3F * v = verts + i;
+		VL_Size rep = (VL_Size)i;
+		uint64_t c[3];
+		vl_weld_cell(c, v, vmin, 1 / cell);
+		for (int dz = -1; dz <= 1; dz++) {
+			for (int dy = -1; dy <= 1; dy++) {
+				for (int dx = -1; dx <= 1; dx++) {
+					uint64_t nx = c[0] + dx, ny = c[1] + dy, nz = c[2] + dz, key;
+					if ((nx > 0x1fffff) || (ny > 0x1fffff) || (nz > 0x1fffff)) {
+						continue;
+					}
+					key = vl_morton_spread(nx) | (vl_morton_spread(ny) << 1) | (vl_morton_spread(nz) << 2);
+					for (VL_Size j = vl_lower_bound_u64(keys, nverts, key); (j < nverts) && (keys[j] == key); j++) {
+						const VL_Vector3F * w = verts + order[j];
+						VL_Float dx2 = w->x - v->x, dy2 = w->y - v->y, dz2 = w->z - v->z;
+						if ((order[j] < rep) && (dx2 * dx2 + dy2 * dy2 + dz2 * dz2 <= tol2)) {
+							rep = order[j];
+						}
+					}
+				}
+			}
+		}
+		remap[i] = rep;
+	}
+	for (VL_Size i = 0; i < nverts; i++) {
+		remap[i] = remap[remap[i]];
+	}
+	free(keys);
+	free(order);
+	return true;
+}
+
+
+/*
+ * Corners of face t in ascending index order
+ */
+_VL_STATIC_ void vl_face_sorted_corners(VL_Size out[3], const VL_Size * const t) {
+	out[0] = VL_MIN(VL_MIN(t[0], t[1]), t[2]);
+	out[2] = VL_MAX(VL_MAX(t[0], t[1]), t[2]);
+	out[1] = t[0] + t[1] + t[2] - out[0] - out[2];
+}
+
+
+/*
+ * Drop degenerated and duplicated faces and sort the rest along Morton curve of their centroids
+ * Duplicates are found by sorting faces on their ascending index triple, so corner order does not matter,
+ * the centroid key only orders faces which are kept
+ *
+ * Return:       false if memory allocation failed
+ * @faces:       Input and output faces, compacted in place
+ * @nfaces:      Input and output face count
+ * @nverts:      Input vertex count, bounds indices of faces
+ */
+_VL_STATIC_ bool vl_sort_faces(
+	_VL_IN_  VL_Size * const           faces,
+	_VL_IN_  VL_Size * const           nfaces,
+	_VL_IN_  const VL_Vector3F * const verts,
+	_VL_IN_  const VL_Size             nverts,
+	_VL_IN_  const VL_Vector3F * const vmin,
+	_VL_IN_  const VL_Vector3F * const vmax
+	) {
+	const VL_Float extent = VL_MAX(VL_MAX(vmax->x - vmin->x, vmax->y - vmin->y), vmax->z - vmin->z);
+	const VL_Float inv_cell = extent > 0 ? (VL_Float)0x1fffff / extent : (VL_Float)1;
+	uint64_t * keys = (uint64_t *)malloc(sizeof(uint64_t) * (*nfaces + 1));
+	VL_Size * order = (VL_Size *)malloc(sizeof(VL_Size) * (*nfaces + 1));
+	VL_Size * sorted = (VL_Size *)malloc(sizeof(VL_Size) * (*nfaces * 3 + 1));
+	VL_Size nkeys = 0, nkept = 0;
+	unsigned int nbits = 0;
+	bool ok = true;
+
+	if ((NULL == keys) || (NULL == order) || (NULL == sorted)) {
+		free(keys);
+		free(order);
+		free(sorted);
+		return false;
+	}
+	while ((nbits < 64) && (((uint64_t)1 << nbits) < (uint64_t)nverts)) {
+		nbits++;
+	}
+	for (VL_Size f = 0; f < *nfaces; f++) {
+		const VL_Size * t = faces + f * 3;
+		VL_Vector3F ab, ac, n;
+		VL_Float len2;
+		if ((t[0] == t[1]) || (t[1] == t[2]) || (t[0] == t[2])) {
+			continue;
+		}
+		vl_vec3_sub(&ab, verts + t[1], verts + t[0]);
+		vl_vec3_sub(&ac, verts + t[2], verts + t[0]);
+		vl_vec3_cross(&n, &ab, &ac);
+		vl_vec3_dot(&len2, &n, &n);
+		if (len2 == 0) {
+			continue;
+		}
+		order[nkeys++] = f;
+	}
+
+	// Stable passes on highest, middle then lowest corner leave faces in ascending triple order,
+	// duplicates end up adjacent with the first of them in input order leading
+	for (int k = 2; (k >= 0) && ok; k--) {
+		for (VL_Size i = 0; i < nkeys; i++) {
+			VL_Size s[3];
+			vl_face_sorted_corners(s, faces + order[i] * 3);
+			keys[i] = s[k];
+		}
+		ok = vl_radix_sort_u64(keys, order, nkeys, nbits);
+	}
+	for (VL_Size i = 0; (i < nkeys) && ok; i++) {
+		VL_Size s[3], prev[3];
+		vl_face_sorted_corners(s, faces + order[i] * 3);
+		if (i > 0) {
+			vl_face_sorted_corners(prev, faces + order[i - 1] * 3);
+			if ((s[0] == prev[0]) && (s[1] == prev[1]) && (s[2] == prev[2])) {
+				continue;
+			}
+		}
+		order[nkept++] = order[i];
+	}
+
+	for (VL_Size i = 0; (i < nkept) && ok; i++) {
+		VL_Size s[3];
+		VL_Vector3F centroid;
+		uint64_t c[3];
+		vl_face_sorted_corners(s, faces + order[i] * 3);
+		centroid.x = (verts[s[0]].x + verts[s[1]].x + verts[s[2]].x) / 3;
+		centroid.y = (verts[s[0]].y + verts[s[1]].y + verts[s[2]].y) / 3;
+		centroid.z = (verts[s[0]].z + verts[s[1]].z + verts[s[2]].z) / 3;
+		vl_weld_cell(c, &centroid, vmin, inv_cell);
+		keys[i] = vl_morton_spread(c[0]) | (vl_morton_spread(c[1]) << 1) | (vl_morton_spread(c[2]) << 2);
+	}
+	if (ok) {
+		ok = vl_radix_sort_u64(keys, order, nkept, 63);
+	}
+	if (ok) {
+		for (VL_Size i = 0; i < nkept; i++) {
+			memcpy(sorted + i * 3, faces + order[i] * 3, sizeof(VL_Size) * 3);
+		}
+		memcpy(faces, sorted, sizeof(VL_Size) * nkept * 3);
+		*nfaces = nkept;
+	}
+	free(keys);
+	free(order);
+	free(sorted);
+	return ok;
+}
+
+
+/*
+ * Cache file is this header followed by npoints VL_Vector3F, header size keeps points aligned
+ * File name holds key, check is a second independent hash, together they make a 128 bit key
+ */
+typedef enum {
+	VL_ECacheKindPointCloud = 1,
+	VL_ECacheKindVolume     = 2,
+} VL_CacheKind;
+
+
+typedef struct {
+	char     magic[4];
+	uint32_t version;
+	uint32_t kind;
+	uint32_t float_size;
+	uint64_t key;
+	uint64_t npoints;
+	double   vsize;
+	uint64_t check;
+	uint64_t nverts;
+	uint64_t nfaces;
+} VL_CacheFileHeader;
+
+
+#define VL_CACHE_HASH_BLOCK 4096
+// Seconds after which a temporary file of cache directory is taken as left over by a writer which died
+#define VL_CACHE_TEMP_AGE 3600
+
+
+/*
+ * 64 bit word hash steps, murmur3 mixing, vl_hash_mix2 is the second lane with its own constants
+ */
+_VL_STATIC_ uint64_t vl_hash_mix(uint64_t h, uint64_t w) {
+	w *= 0x87c37b91114253d5ULL;
+	w = (w << 31) | (w >> 33);
+	w *= 0x4cf5ad432745937fULL;
+	h ^= w;
+	h = (h << 27) | (h >> 37);
+	return h * 5 + 0x52dce729;
+}
+
+
+_VL_STATIC_ uint64_t vl_hash_mix2(uint64_t h, uint64_t w) {
+	w *= 0x4cf5ad432745937fULL;
+	w = (w << 33) | (w >> 31);
+	w *= 0x87c37b91114253d5ULL;
+	h ^= w;
+	h = (h << 31) | (h >> 33);
+	return h * 5 + 0x38495ab5;
+}
+
+
+_VL_STATIC_ uint64_t vl_hash_final(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+
+_VL_STATIC_ uint64_t vl_double_bits(const double v) {
+	uint64_t w;
+	memcpy(&w, &v, sizeof(w));
+	return w;
+}
+
+
+/*
+ * Cache key of voxelizing mesh, hashed over vertices and indices as read, not as laid out,
+ * so the same mesh behind different VL_MeshDesc layouts shares entries
+ * Blocks of VL_CACHE_HASH_BLOCK elements are hashed in parallel and chained in order,
+ * which keeps keys independent of thread count
+ *
+ * Return:       false if memory allocation failed
+ * @key:         Output hash naming the entry
+ * @check:       Output second hash of the same words, stored in the entry
+ */
+_VL_STATIC_ bool vl_cache_key(
+	_VL_OUT_ uint64_t * const          out_key,
+	_VL_OUT_ uint64_t * const          out_check,
+	_VL_IN_  const VL_MeshDesc * const mesh,
+	_VL_IN_  const VL_Float            vsize,
+	_VL_IN_  const VL_CacheKind        kind
+	) {
+	const VL_Size nvblocks = (mesh->nverts + VL_CACHE_HASH_BLOCK - 1) / VL_CACHE_HASH_BLOCK;
+	const VL_Size nfblocks = (mesh->nfaces + VL_CACHE_HASH_BLOCK - 1) / VL_CACHE_HASH_BLOCK;
+	uint64_t * blocks = (uint64_t *)malloc(sizeof(uint64_t) * 2 * (nvblocks + nfblocks + 1));
+	uint64_t h = 0, h2 = 0;
+	uint64_t head[7];
+
+	if (NULL == blocks) {
+		return false;
+	}
+	#pragma omp parallel for
+	for (long b = 0; b < (long)(nvblocks + nfblocks); b++) {
+		uint64_t bh = (uint64_t)b, bh2 = (uint64_t)b;
+		if ((VL_Size)b < nvblocks) {
+			const VL_Size begin = (VL_Size)b * VL_CACHE_HASH_BLOCK;
+			const VL_Size end = VL_MIN(begin + VL_CACHE_HASH_BLOCK, mesh->nverts);
+			for (VL_Size i = begin; i < end; i++) {
+				VL_Vector3F v;
+				uint64_t w[3];
+				vl_mesh_desc_vert(&v, mesh, i);
+				w[0] = vl_double_bits(v.x);
+				w[1] = vl_double_bits(v.y);
+				w[2] = vl_double_bits(v.z);
+				for (int k = 0; k < 3; k++) {
+					bh = vl_hash_mix(bh, w[k]);
+					bh2 = vl_hash_mix2(bh2, w[k]);
+				}
+			}
+		} else {
+			const VL_Size begin = ((VL_Size)b - nvblocks) * VL_CACHE_HASH_BLOCK;
+			const VL_Size end = VL_MIN(begin + VL_CACHE_HASH_BLOCK, mesh->nfaces);
+			for (VL_Size f = begin; f < end; f++) {
+				for (int k = 0; k < 3; k++) {
+					const uint64_t w = vl_mesh_desc_index(mesh, f, k);
+					bh = vl_hash_mix(bh, w);
+					bh2 = vl_hash_mix2(bh2, w);
+				}
+			}
+		}
+		blocks[2 * b] = bh;
+		blocks[2 * b + 1] = bh2;
+	}
+	head[0] = VL_CACHE_VERSION;
+	head[1] = kind;
+	head[2] = sizeof(VL_Float);
+	head[3] = sizeof(VL_Size);
+	head[4] = vl_double_bits(vsize);
+	head[5] = mesh->nverts;
+	head[6] = mesh->nfaces;
+	for (int k = 0; k < 7; k++) {
+		h = vl_hash_mix(h, head[k]);
+		h2 = vl_hash_mix2(h2, head[k]);
+	}
+	for (VL_Size b = 0; b < nvblocks + nfblocks; b++) {
+		h = vl_hash_mix(h, blocks[2 * b]);
+		h2 = vl_hash_mix2(h2, blocks[2 * b + 1]);
+	}
+	free(blocks);
+	*out_key = vl_hash_final(h);
+	*out_check = vl_hash_final(h2 ^ 0x9e3779b97f4a7c15ULL);
+	return true;
+}
+
+
+_VL_STATIC_ void vl_cache_header_init(
+	_VL_OUT_ VL_CacheFileHeader * const header,
+	_VL_IN_  const uint64_t             key,
+	_VL_IN_  const uint64_t             check,
+	_VL_IN_  const VL_MeshDesc * const  mesh,
+	_VL_IN_  const VL_CacheKind         kind,
+	_VL_IN_  const VL_Size              npoints,
+	_VL_IN_  const VL_Float             vsize
+	) {
+	memset(header, 0, sizeof(VL_CacheFileHeader));
+	memcpy(header->magic, "VLC", 4);
+	header->version = VL_CACHE_VERSION;
+	header->kind = kind;
+	header->float_size = sizeof(VL_Float);
+	header->key = key;
+	header->npoints = npoints;
+	header->vsize = vsize;
+	header->check = check;
+	header->nverts = mesh->nverts;
+	header->nfaces = mesh->nfaces;
+}
+
+
+/*
+ * Whether header read from file of bytes size is the entry expected
+ */
+_VL_STATIC_ bool vl_cache_header_valid(
+	_VL_IN_  const VL_CacheFileHeader * const header,
+	_VL_IN_  const VL_CacheFileHeader * const expected,
+	_VL_IN_  const double                     bytes
+	) {
+	if ((memcmp(header->magic, expected->magic, 4) != 0) ||
+		(header->version != expected->version) ||
+		(header->kind != expected->kind) ||
+		(header->float_size != expected->float_size) ||
+		(header->key != expected->key) ||
+		(header->vsize != expected->vsize) ||
+		(header->check != expected->check) ||
+		(header->nverts != expected->nverts) ||
+		(header->nfaces != expected->nfaces)) {
+		return false;
+	}
+	if (header->kind == VL_ECacheKindPointCloud) {
+		return bytes == sizeof(VL_CacheFileHeader) + (double)header->npoints * sizeof(VL_Vector3F);
+	}
+	return bytes == sizeof(VL_CacheFileHeader);
+}
+
+
+/*
+ * Path of cache entry, <dir>/<16 hex digits of key><suffix>
+ *
+ * Return:       Path to be freed by caller, NULL if memory allocation failed
+ */
+_VL_STATIC_ char * vl_cache_path(const char * const dir, const uint64_t key, const char * const suffix) {
+	const size_t len = strlen(dir) + strlen(suffix) + 18;
+	char * path = (char *)malloc(len);
+	if (path) {
+		snprintf(path, len, "%s/%08lx%08lx%s", dir,
+				 (unsigned long)(key >> 32), (unsigned long)(key & 0xffffffff), suffix);
+	}
+	return path;
+}
+
+
+/*
+ * Map cache entry of path read only and mark it used
+ *
+ * Return:       Whether path holds the expected entry
+ */
+_VL_STATIC_ bool vl_cache_map(
+	_VL_OUT_ VL_CachedPointCloud * const      out,
+	_VL_IN_  const char * const               path,
+	_VL_IN_  const VL_CacheFileHeader * const expected
+	) {
+	VL_CacheFileHeader header;
+	void * map = NULL;
+	double bytes;
+#ifdef _WIN32
+	HANDLE file, mapping;
+	LARGE_INTEGER size;
+
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == file) {
+		return false;
+	}
+	if (!GetFileSizeEx(file, &size) || (size.QuadPart < (LONGLONG)sizeof(VL_CacheFileHeader)) ||
+		((double)size.QuadPart > (double)SIZE_MAX)) {
+		CloseHandle(file);
+		return false;
+	}
+	bytes = (double)size.QuadPart;
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping) {
+		map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+	if (NULL == map) {
+		return false;
+	}
+	memcpy(&header, map, sizeof(header));
+	if (!vl_cache_header_valid(&header, expected, bytes)) {
+		UnmapViewOfFile(map);
+		return false;
+	}
+	_utime(path, NULL);
+#else
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return false;
+	}
+	if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(VL_CacheFileHeader)) ||
+		((double)st.st_size > (double)SIZE_MAX)) {
+		close(fd);
+		return false;
+	}
+	bytes = (double)st.st_size;
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (MAP_FAILED == map) {
+		return false;
+	}
+	memcpy(&header, map, sizeof(header));
+	if (!vl_cache_header_valid(&header, expected, bytes)) {
+		munmap(map, (size_t)st.st_size);
+		return false;
+	}
+	utime(path, NULL);
+#endif
+	out->points = (VL_Vector3F *)((char *)map + sizeof(VL_CacheFileHeader));
+	out->npoints = (VL_Size)header.npoints;
+	out->map = map;
+	out->map_bytes = (size_t)bytes;
+	return true;
+}
+
+
+/*
+ * Read header of cache entry of path and mark it used
+ *
+ * Return:       Whether path holds the expected entry
+ */
+_VL_STATIC_ bool vl_cache_read_header(
+	_VL_OUT_ VL_CacheFileHeader * const       out_header,
+	_VL_IN_  const char * const               path,
+	_VL_IN_  const VL_CacheFileHeader * const expected
+	) {
+	struct stat st;
+	bool ok;
+#ifdef _WIN32
+	int fd = _open(path, _O_RDONLY | _O_BINARY);
+#else
+	int fd = open(path, O_RDONLY);
+#endif
+
+	if (fd < 0) {
+		return false;
+	}
+	ok = (fstat(fd, &st) == 0) &&
+		 (vl_fd_read(fd, out_header, sizeof(VL_CacheFileHeader)) == (long)sizeof(VL_CacheFileHeader)) &&
+		 vl_cache_header_valid(out_header, expected, (double)st.st_size);
+#ifdef _WIN32
+	_close(fd);
+	if (ok) { _utime(path, NULL); }
+#else
+	close(fd);
+	if (ok) { utime(path, NULL); }
+#endif
+	return ok;
+}
+
+
+typedef struct {
+	char * path;
+	double bytes;
+	double mtime;
+} VL_CacheEntry;
+
+
+_VL_STATIC_ int vl_cache_entry_cmp(const void * a, const void * b) {
+	const VL_CacheEntry * ea = (const VL_CacheEntry *)a, * eb = (const VL_CacheEntry *)b;
+	return ea->mtime < eb->mtime ? -1 : ea->mtime > eb->mtime ? 1 : 0;
+}
+
+
+/*
+ * Whether file name is a cache entry, 16 hex digits and .vlc,
+ * or when temp is set a temporary file of vl_cache_publish, 16 hex digits, a dot and anything ending in .tmp
+ */
+_VL_STATIC_ bool vl_cache_is_entry_name(const char * const name, const bool temp) {
+	const size_t len = strlen(name);
+	if (temp ? ((len < 21) || (name[16] != '.') || (strcmp(name + len - 4, ".tmp") != 0)) :
+			   ((len != 20) || (strcmp(name + 16, ".vlc") != 0))) {
+		return false;
+	}
+	for (int i = 0; i < 16; i++) {
+		if (!(((name[i] >= '0') && (name[i] <= '9')) || ((name[i] >= 'a') && (name[i] <= 'f')))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+_VL_STATIC_ bool vl_cache_entry_push(
+	_VL_IN_  VL_CacheEntry ** const entries,
+	_VL_IN_  VL_Size * const        nentries,
+	_VL_IN_  VL_Size * const        capacity,
+	_VL_IN_  const char * const     dir,
+	_VL_IN_  const char * const     name
+	) {
+	const size_t len = strlen(dir) + strlen(name) + 2;
+	struct stat st;
+	VL_CacheEntry * e;
+
+	if (*nentries == *capacity) {
+		VL_Size new_capacity = *capacity ? *capacity * 2 : 64;
+		VL_CacheEntry * grown = (VL_CacheEntry *)realloc(*entries, sizeof(VL_CacheEntry) * new_capacity);
+		if (NULL == grown) {
+			return false;
+		}
+		*entries = grown;
+		*capacity = new_capacity;
+	}
+	e = *entries + *nentries;
+	e->path = (char *)malloc(len);
+	if (NULL == e->path) {
+		return false;
+	}
+	snprintf(e->path, len, "%s/%s", dir, name);
+	if (stat(e->path, &st) != 0) {
+		// Evicted by another process meanwhile
+		free(e->path);
+		return true;
+	}
+	e->bytes = (double)st.st_size;
+	e->mtime = (double)st.st_mtime;
+	(*nentries)++;
+	return true;
+}
+
+
+/*
+ * Delete temporary file name of dir if it was last written more than VL_CACHE_TEMP_AGE ago,
+ * younger ones may still be written
+ */
+_VL_STATIC_ void vl_cache_remove_stale_temp(const char * const dir, const char * const name) {
+	const size_t len = strlen(dir) + strlen(name) + 2;
+	char * path = (char *)malloc(len);
+	struct stat st;
+
+	if (NULL == path) {
+		return;
+	}
+	snprintf(path, len, "%s/%s", dir, name);
+	if ((stat(path, &st) == 0) && (difftime(time(NULL), st.st_mtime) > VL_CACHE_TEMP_AGE)) {
+		remove(path);
+	}
+	free(path);
+}
+
+
+/*
+ * Delete least recently used entries of dir until the rest fit in max_bytes,
+ * along with stale temporary files
+ * Concurrent processes may evict the same entries, losing the race to unlink is harmless
+ */
+_VL_STATIC_ void vl_cache_evict(const char * const dir, const double max_bytes) {
+	VL_CacheEntry * entries = NULL;
+	VL_Size nentries = 0, capacity = 0;
+	double total = 0.0;
+	bool ok = true;
+#ifdef _WIN32
+	WIN32_FIND_DATAA data;
+	HANDLE find;
+	char * pattern = (char *)malloc(strlen(dir) + 8);
+
+	if (NULL == pattern) {
+		return;
+	}
+	sprintf(pattern, "%s/*", dir);
+	find = FindFirstFileA(pattern, &data);
+	free(pattern);
+	if (INVALID_HANDLE_VALUE == find) {
+		return;
+	}
+	do {
+		if (vl_cache_is_entry_name(data.cFileName, false)) {
+			ok = vl_cache_entry_push(&entries, &nentries, &capacity, dir, data.cFileName);
+		} else if (vl_cache_is_entry_name(data.cFileName, true)) {
+			vl_cache_remove_stale_temp(dir, data.cFileName);
+		}
+	} while (ok && FindNextFileA(find, &data));
+	FindClose(find);
+#else
+	struct dirent * ent;
+	DIR * d = opendir(dir);
+
+	if (NULL == d) {
+		return;
+	}
+	while (ok && (NULL != (ent = readdir(d)))) {
+		if (vl_cache_is_entry_name(ent->d_name, false)) {
+			ok = vl_cache_entry_push(&entries, &nentries, &capacity, dir, ent->d_name);
+		} else if (vl_cache_is_entry_name(ent->d_name, true)) {
+			vl_cache_remove_stale_temp(dir, ent->d_name);
+		}
+	}
+	closedir(d);
+#endif
+	for (VL_Size i = 0; i < nentries; i++) {
+		total += entries[i].bytes;
+	}
+	if (ok && (total > max_bytes)) {
+		qsort(entries, nentries, sizeof(VL_CacheEntry), vl_cache_entry_cmp);
+		for (VL_Size i = 0; (i < nentries) && (total > max_bytes); i++) {
+			remove(entries[i].path);
+			total -= entries[i].bytes;
+		}
+	}
+	for (VL_Size i = 0; i < nentries; i++) {
+		free(entries[i].path);
+	}
+	free(entries);
+}
+
+
+/*
+ * Write entry to a temporary file of dir and rename it over path, so readers see either no entry or a whole one
+ * Failing to publish only loses caching, it is not reported
+ */
+_VL_STATIC_ void vl_cache_publish(
+	_VL_IN_  const char * const               dir,
+	_VL_IN_  const char * const               path,
+	_VL_IN_  const VL_CacheFileHeader * const header,
+	_VL_IN_  const VL_Vector3F * const        points,
+	_VL_IN_  const double                     max_bytes
+	) {
+	char suffix[64];
+	char * temp_path = NULL;
+	bool ok;
+	int fd = -1;
+
+	// Process id and address of a local tell concurrent writers apart, threads run on distinct stacks,
+	// creation is exclusive and files left over by writers which died are skipped by the next attempt
+	for (int attempt = 0; (fd < 0) && (attempt < 8); attempt++) {
+#ifdef _WIN32
+		snprintf(suffix, sizeof(suffix), ".%d.%llx.%d.tmp", _getpid(), (unsigned long long)(uintptr_t)&fd, attempt);
+#else
+		snprintf(suffix, sizeof(suffix), ".%ld.%llx.%d.tmp", (long)getpid(), (unsigned long long)(uintptr_t)&fd, attempt);
+#endif
+		temp_path = vl_cache_path(dir, header->key, suffix);
+		if (NULL == temp_path) {
+			return;
+		}
+#ifdef _WIN32
+		fd = _open(temp_path, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+		fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+#endif
+		if (fd < 0) {
+			free(temp_path);
+			temp_path = NULL;
+			if (errno != EEXIST) {
+				return;
+			}
+		}
+	}
+	if (fd < 0) {
+		return;
+	}
+	ok = vl_fd_write_all(fd, header, sizeof(VL_CacheFileHeader));
+	if (ok && (header->kind == VL_ECacheKindPointCloud)) {
+		ok = vl_fd_write_all(fd, points, sizeof(VL_Vector3F) * (size_t)header->npoints);
+	}
+#ifdef _WIN32
+	ok = (_close(fd) == 0) && ok;
+	ok = ok && MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING);
+#else
+	ok = (close(fd) == 0) && ok;
+	ok = ok && (rename(temp_path, path) == 0);
+#endif
+	if (!ok) {
+		remove(temp_path);
+	}
+	free(temp_path);
+	if (ok && (max_bytes > 0.0)) {
+		vl_cache_evict(dir, max_bytes);
+	}
+}
+
+
+/*
+ * Next voxel of row from x on which is solid when set or empty otherwise, cx if none
+ */
+_VL_STATIC_ VL_Size vl_grid_row_next(const uint64_t * const row, const VL_Size cx, const VL_Size x, const bool set) {
+	const VL_Size nwords = vl_grid_row_words(cx);
+	VL_Size w = x / 64;
+	uint64_t bits;
+
+	if (x >= cx) {
+		return cx;
+	}
+	bits = (set ? row[w] : ~row[w]) & (~(uint64_t)0 << (x % 64));
+	while (bits == 0) {
+		if (++w == nwords) {
+			return cx;
+		}
+		bits = set ? row[w] : ~row[w];
+	}
+	return VL_MIN(w * 64 + (VL_Size)vl_ctz64(bits), cx);
+}
+
+
+/*
+ * Set voxels [x0, x1) of row
+ */
+_VL_STATIC_ void vl_grid_row_fill(uint64_t * const row, const VL_Size x0, const VL_Size x1) {
+	for (VL_Size x = x0; x < x1;) {
+		const VL_Size n = VL_MIN(64 - x % 64, x1 - x);
+		row[x / 64] |= (n == 64 ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1)) << (x % 64);
+		x += n;
+	}
+}
+
+
+/*
+ * Root of run i, halving path on the way
+ */
+_VL_STATIC_ VL_Size vl_labels_find(VL_Size * const parent, VL_Size i) {
+	while (parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+
+/*
+ * Union runs a and b, the larger root links to the smaller so every root is the first run of its set
+ */
+_VL_STATIC_ void vl_labels_union(VL_Size * const parent, const VL_Size a, const VL_Size b) {
+	VL_Size ra = vl_labels_find(parent, a), rb = vl_labels_find(parent, b);
+	if (ra < rb) {
+		parent[rb] = ra;
+	} else if (rb < ra) {
+		parent[ra] = rb;
+	}
+}
+
+
+/*
+ * Union runs of row (y, z) with touching runs of earlier row (y + dy, z + dz),
+ * runs touch when their x ranges overlap after widening by tol
+ */
+_VL_STATIC_ void vl_labels_merge_rows(
+	_VL_IN_  VL_Size * const           parent,
+	_VL_IN_  const VL_Labels * const   labels,
+	_VL_IN_  const VL_Size             y,
+	_VL_IN_  const VL_Size             z,
+	_VL_IN_  const int                 dy,
+	_VL_IN_  const int                 dz,
+	_VL_IN_  const VL_Size             tol
+	) {
+	const VL_Size cy = labels->header.cy;
+	VL_Size a, aend, b, bend;
+
+	if (((dy < 0) && (y == 0)) || ((dy > 0) && (y + 1 == cy)) || ((dz < 0) && (z == 0))) {
+		return;
+	}
+	a = labels->row_offsets[z * cy + y];
+	aend = labels->row_offsets[z * cy + y + 1];
+	b = labels->row_offsets[(z + dz) * cy + y + dy];
+	bend = labels->row_offsets[(z + dz) * cy + y + dy + 1];
+	while ((a < aend) && (b < bend)) {
+		if ((labels->run_x0[a] < labels->run_x1[b] + tol) && (labels->run_x0[b] < labels->run_x1[a] + tol)) {
+			vl_labels_union(parent, a, b);
+		}
+		// Advance the run that ends first, it can not touch any later run of the other row
+		if (labels->run_x1[a] < labels->run_x1[b]) {
+			a++;
+		} else {
+			b++;
+		}
+	}
+}
+
+
+/*
+ * Union runs of row (y, z) with all touching runs of rows scanned before it
+ * Faces touch along y and z, edges also along (dy, dz) diagonals or with x off by one, corners both
+ */
+_VL_STATIC_ void vl_labels_merge_row(
+	_VL_IN_  VL_Size * const           parent,
+	_VL_IN_  const VL_Labels * const   labels,
+	_VL_IN_  const VL_Size             y,
+	_VL_IN_  const VL_Size             z,
+	_VL_IN_  const VL_Connectivity     connectivity,
+	_VL_IN_  const bool                within_slab
+	) {
+	const VL_Size face_tol = connectivity == VL_EConnect6 ? 0 : 1;
+	const VL_Size edge_tol = connectivity == VL_EConnect26 ? 1 : 0;
+
+	if (within_slab) {
+		vl_labels_merge_rows(parent, labels, y, z, -1, 0, face_tol);
+	}
+	vl_labels_merge_rows(parent, labels, y, z, 0, -1, face_tol);
+	if (connectivity != VL_EConnect6) {
+		vl_labels_merge_rows(parent, labels, y, z, -1, -1, edge_tol);
+		vl_labels_merge_rows(parent, labels, y, z,  1, -1, edge_tol);
+	}
+}
+
+
+#define VL_LABELS_SLAB 8
+
+
+/*
+ * Component index sorted by voxel count, larger first and earlier first among equals
+ */
+typedef struct {
+	VL_Size count;
+	VL_Size index;
+} VL_ComponentOrder;
+
+
+_VL_STATIC_ int vl_component_order_cmp(const void * a, const void * b) {
+	const VL_ComponentOrder * oa = (const VL_ComponentOrder *)a, * ob = (const VL_ComponentOrder *)b;
+	if (oa->count != ob->count) {
+		return oa->count > ob->count ? -1 : 1;
+	}
+	return oa->index < ob->index ? -1 : oa->index > ob->index ? 1 : 0;
+}
+
+
+/*
+ * Keep largest keep components, relabeled 1 to keep by decreasing size, runs of the rest get label 0
+ *
+ * Return:       false if memory allocation failed
+ */
+_VL_STATIC_ bool vl_labels_keep_largest(VL_Labels * const labels, const VL_Size keep) {
+	const VL_Size n = labels->ncomponents, nkept = VL_MIN(keep, n);
+	VL_ComponentOrder * order = (VL_ComponentOrder *)malloc(sizeof(VL_ComponentOrder) * (n + 1));
+	VL_Size * relabel = (VL_Size *)malloc(sizeof(VL_Size) * (n + 1));
+	VL_Component * kept = (VL_Component *)malloc(sizeof(VL_Component) * (nkept + 1));
+
+	if ((NULL == order) || (NULL == relabel) || (NULL == kept)) {
+		free(order);
+		free(relabel);
+		free(kept);
+		return false;
+	}
+	for (VL_Size i = 0; i < n; i++) {
+		order[i].count = labels->components[i].count;
+		order[i].index = i;
+	}
+	qsort(order, n, sizeof(VL_ComponentOrder), vl_component_order_cmp);
+	relabel[0] = 0;
+	for (VL_Size i = 0; i < n; i++) {
+		relabel[order[i].index + 1] = i < nkept ? i + 1 : 0;
+		if (i < nkept) {
+			kept[i] = labels->components[order[i].index];
+		}
+	}
+	#pragma omp parallel for
+	for (long i = 0; i < (long)labels->nruns; i++) {
+		labels->run_labels[i] = relabel[labels->run_labels[i]];
+	}
+	free(labels->components);
+	labels->components = kept;
+	labels->ncomponents = nkept;
+	free(order);
+	free(relabel);
+	return true;
+}
+
+
+/*
+ * dst(p) = src(p + d) without base, dst(p) = base(p) op src(p + d) otherwise, base may be dst itself
+ * Grids may differ in dims but share voxel lattice, base has header of dst, voxels out of src read as empty
+ *
+ * Return:       false if memory allocation failed
+ */
+_VL_STATIC_ bool vl_grid_shift_combine(
+	_VL_IN_  VL_VoxelGrid * const       dst,
+	_VL_IN_  const VL_VoxelGrid * const base,
+	_VL_IN_  const VL_VoxelGrid * const src,
+	_VL_IN_  const long long            dx,
+	_VL_IN_  const long long            dy,
+	_VL_IN_  const long long            dz,
+	_VL_IN_  const VL_BoolOp            op
+	) {
+	bool failed = false;
+
+	#pragma omp parallel
+	{
+		uint64_t * rb = (uint64_t *)malloc(sizeof(uint64_t) * (dst->nwords + 1));
+		if (NULL == rb) {
+			#pragma omp atomic write
+			failed = true;
+		}
+		#pragma omp for schedule(static)
+		for (long z = 0; z < (long)dst->header.cz; z++) {
+			for (VL_Size y = 0; (y < dst->header.cy) && (NULL != rb); y++) {
+				uint64_t * row = vl_grid_row(dst, y, (VL_Size)z);
+				if (NULL == base) {
+					vl_grid_row_extract(row, src, dx, (long long)y + dy, z + dz, dst->nwords);
+				} else {
+					if (base != dst) {
+						memcpy(row, vl_grid_row(base, y, (VL_Size)z), sizeof(uint64_t) * dst->nwords);
+					}
+					vl_grid_row_extract(rb, src, dx, (long long)y + dy, z + dz, dst->nwords);
+					vl_grid_row_combine(row, rb, dst->nwords, op);
+				}
+				if (dst->header.cx % 64) {
+					row[dst->nwords - 1] &= ((uint64_t)1 << (dst->header.cx % 64)) - 1;
+				}
+			}
+		}
+		free(rb);
+	}
+	return !failed;
+}
+
+
+/*
+ * dst(p) = op of src(p + k * e) for k in [-w, w], e the unit step along axis 0, 1 or 2
+ * Runs of n = w + 1 voxels are built by doubling, run(p) = run(p) op run(p + m) with m up to the
+ * covered length so far, then dst(p) = run(p) op run(p - w), so a pass costs log2(w) + 1 sweeps
+ * dst, src and tmp are distinct grids of one header
+ *
+ * Return:       false if memory allocation failed
+ */
+_VL_STATIC_ bool vl_grid_window(
+	_VL_OUT_ VL_VoxelGrid * const       dst,
+	_VL_IN_  const VL_VoxelGrid * const src,
+	_VL_IN_  VL_VoxelGrid * const       tmp,
+	_VL_IN_  const int                  axis,
+	_VL_IN_  const VL_Size              w,
+	_VL_IN_  const VL_BoolOp            op
+	) {
+	const VL_VoxelGrid * cur = src;
+	VL_Size nsteps = 1, step = 0;
+
+	if (w == 0) {
+		memcpy(dst->bits, src->bits, sizeof(uint64_t) * src->nwords * src->header.cy * src->header.cz);
+		return true;
+	}
+	for (VL_Size have = 1; have < w + 1; have += VL_MIN(have, w + 1 - have)) {
+		nsteps++;
+	}
+	// Alternate targets so that the last sweep lands in dst
+	for (VL_Size have = 1; step < nsteps; step++) {
+		VL_VoxelGrid * next = ((nsteps - 1 - step) % 2 == 0) ? dst : tmp;
+		long long m = (step + 1 < nsteps) ? (long long)VL_MIN(have, w + 1 - have) : -(long long)w;
+		if (!vl_grid_shift_combine(next, cur, cur, axis == 0 ? m : 0, axis == 1 ? m : 0, axis == 2 ? m : 0, op)) {
+			return false;
+		}
+		if (step + 1 < nsteps) {
+			have += (VL_Size)m;
+		}
+		cur = next;
+	}
+	return true;
+}
+
+
+/*
+ * Largest w with w * w <= v, v below 2^62
+ */
+_VL_STATIC_ long long vl_isqrt(const long long v) {
+	long long w = (long long)sqrt((double)v);
+	while (w * w > v) { w--; }
+	while ((w + 1) * (w + 1) <= v) { w++; }
+	return w;
+}
+
+
+/*
+ * Grow x window of row from half width a to b in place, row(p) = op of row(p + k) for k in [-b, b]
+ * Each step combines three copies shifted by at most 2a + 1 so they stay contiguous,
+ * bits past cx are cleared after every step, tmp holds 2 * nwords words
+ */
+_VL_STATIC_ void vl_grid_row_window_grow(
+	_VL_IN_  uint64_t * const row,
+	_VL_IN_  uint64_t * const tmp,
+	_VL_IN_  const VL_Size    nwords,
+	_VL_IN_  const VL_Size    cx,
+	_VL_IN_  long long        a,
+	_VL_IN_  const long long  b,
+	_VL_IN_  const VL_BoolOp  op
+	) {
+	uint64_t * copy = tmp, * shifted = tmp + nwords;
+
+	while (a < b) {
+		const long long d = VL_MIN(b - a, 2 * a + 1);
+		memcpy(copy, row, sizeof(uint64_t) * nwords);
+		vl_grid_row_shift(shifted, copy, nwords, d, nwords);
+		vl_grid_row_combine(row, shifted, nwords, op);
+		vl_grid_row_shift(shifted, copy, nwords, -d, nwords);
+		vl_grid_row_combine(row, shifted, nwords, op);
+		if (cx % 64) {
+			row[nwords - 1] &= ((uint64_t)1 << (cx % 64)) - 1;
+		}
+		a += d;
+	}
+}
+
+
+/*
+ * dst(p) = op of src(p + d) for every d with |d|^2 <= r^2, dst has header of src
+ * One sweep per dz, every source row of slice z + dz grows its x window from the narrowest width
+ * of the disk slice to the widest and combines each width into destination rows -dy and +dy away,
+ * so sphere costs 2r + 1 sweeps of O(r) row operations per row, O(r^2) per row in all against
+ * O(log r) of box and cross, with no temporary grid. A sphere is not separable into axis passes
+ * the way a box is, so this trades the quadratic row count for an exact element
+ *
+ * Return:       false if memory allocation failed or radius is 2^31 or more
+ */
+_VL_STATIC_ bool vl_grid_morph_sphere(
+	_VL_IN_  VL_VoxelGrid * const       dst,
+	_VL_IN_  const VL_VoxelGrid * const src,
+	_VL_IN_  const VL_Size              radius,
+	_VL_IN_  const VL_BoolOp            op
+	) {
+	const long long r = (long long)radius, cy = (long long)dst->header.cy, cz = (long long)dst->header.cz;
+	const VL_Size nwords = dst->nwords, cx = dst->header.cx;
+	bool failed = false;
+
+	// r * r stays within range of vl_isqrt
+	if (r >= ((long long)1 << 31)) {
+		return false;
+	}
+	// Union starts empty and intersection full, bits past cx stay clear
+	for (VL_Size y = 0; y < dst->header.cy; y++) {
+		for (VL_Size z = 0; z < dst->header.cz; z++) {
+			uint64_t * row = vl_grid_row(dst, y, z);
+			memset(row, op == VL_EBoolUnion ? 0 : 0xff, sizeof(uint64_t) * nwords);
+			if (cx % 64) {
+				row[nwords - 1] &= ((uint64_t)1 << (cx % 64)) - 1;
+			}
+		}
+	}
+	for (long long dz = -r; (dz <= r) && !failed; dz++) {
+		const long long rr = r * r - dz * dz, h = vl_isqrt(rr);
+		#pragma omp parallel
+		{
+			uint64_t * win = (uint64_t *)malloc(sizeof(uint64_t) * (nwords * 3 + 1));
+			if (NULL == win) {
+				#pragma omp atomic write
+				failed = true;
+			}
+			#pragma omp for schedule(static)
+			for (long z = 0; z < (long)cz; z++) {
+				// Source rows out of frame are empty, union skips them and intersection clears
+				// every destination row they reach at once, that is the whole slice or rows within h of its ends
+				if ((z + dz < 0) || (z + dz >= cz)) {
+					for (long long y = 0; (y < cy) && (op != VL_EBoolUnion); y++) {
+						memset(vl_grid_row(dst, (VL_Size)y, (VL_Size)z), 0, sizeof(uint64_t) * nwords);
+					}
+					continue;
+				}
+				for (long long y = 0; (y < cy) && (op != VL_EBoolUnion); y++) {
+					if ((y < h) || (y >= cy - h)) {
+						memset(vl_grid_row(dst, (VL_Size)y, (VL_Size)z), 0, sizeof(uint64_t) * nwords);
+					}
+				}
+				for (long long s = 0; (s < cy) && (NULL != win); s++) {
+					long long a = 0;
+					vl_grid_row_extract(win, src, 0, s, z + dz, nwords);
+					for (long long d = h; d >= 0; d--) {
+						const long long w = vl_isqrt(rr - d * d);
+						vl_grid_row_window_grow(win, win + nwords, nwords, cx, a, w, op);
+						a = w;
+						if ((s - d >= 0) && (s - d < cy)) {
+							vl_grid_row_combine(vl_grid_row(dst, (VL_Size)(s - d), (VL_Size)z), win, nwords, op);
+						}
+						if ((d > 0) && (s + d >= 0) && (s + d < cy)) {
+							vl_grid_row_combine(vl_grid_row(dst, (VL_Size)(s + d), (VL_Size)z), win, nwords, op);
+						}
+					}
+				}
+			}
+			free(win);
+		}
+	}
+	return !failed;
+}
+
+
+/*
+ * Dilate with op union or erode with op intersection in frame of src, voxels out of frame are empty
+ * Box is separable into x, y and z windows, cross is the union of the three windows, sphere is the
+ * union of x windows of half width sqrt(r^2 - dy^2 - dz^2) shifted by every (dy, dz) of its disk,
+ * built by vl_grid_morph_sphere, so sphere costs O(r^2) row operations per row against O(log r) of box and cross
+ *
+ * Return:       false if memory allocation failed
+ * @dst:         Output grid, allocated with header of src
+ */
+_VL_STATIC_ bool vl_grid_morph_frame(
+	_VL_OUT_ VL_VoxelGrid * const       dst,
+	_VL_IN_  const VL_VoxelGrid * const src,
+	_VL_IN_  const VL_MorphElement      element,
+	_VL_IN_  const VL_Size              radius,
+	_VL_IN_  const VL_BoolOp            op
+	) {
+	VL_VoxelGrid t0, t1;
+	bool ok = true;
+
+	memset(&t0, 0, sizeof(VL_VoxelGrid));
+	memset(&t1, 0, sizeof(VL_VoxelGrid));
+	if (!vl_grid_alloc(dst, &src->header)) {
+		return false;
+	}
+	// Sphere works row by row and needs no temporary grid
+	if ((element != VL_EElementSphere) && (!vl_grid_alloc(&t0, &src->header) || !vl_grid_alloc(&t1, &src->header))) {
+		vl_grid_free(&t0);
+		vl_grid_free(dst);
+		return false;
+	}
+	switch (element) {
+		case VL_EElementBox:
+			ok = vl_grid_window(&t0, src, &t1, 0, radius, op) &&
+				 vl_grid_window(&t1, &t0, dst, 1, radius, op) &&
+				 vl_grid_window(dst, &t1, &t0, 2, radius, op);
+			break;
+		case VL_EElementCross:
+			ok = vl_grid_window(dst, src, &t0, 0, radius, op) &&
+				 vl_grid_window(&t1, src, &t0, 1, radius, op) &&
+				 vl_grid_shift_combine(dst, dst, &t1, 0, 0, 0, op) &&
+				 vl_grid_window(&t1, src, &t0, 2, radius, op) &&
+				 vl_grid_shift_combine(dst, dst, &t1, 0, 0, 0, op);
+			break;
+		case VL_EElementSphere:
+			ok = vl_grid_morph_sphere(dst, src, radius, op);
+			break;
+	}
+	vl_grid_free(&t0);
+	vl_grid_free(&t1);
+	if (!ok) {
+		vl_grid_free(dst);
+	}
+	return ok;
+}
+
+
+/*
+ * Copy src into a frame grown by margin voxels on every side, negative margin crops
+ *
+ * Return:       false if memory allocation failed
+ */
+_VL_STATIC_ bool vl_grid_reframe(VL_VoxelGrid * const dst, const VL_VoxelGrid * const src, const long long margin) {
+	VL_VoxelHeader header = src->header;
+	header.origin.x -= margin * header.vsize;
+	header.origin.y -= margin * header.vsize;
+	header.origin.z -= margin * header.vsize;
+	header.cx = (VL_Size)VL_MAX((long long)header.cx + 2 * margin, 0);
+	header.cy = (VL_Size)VL_MAX((long long)header.cy + 2 * margin, 0);
+	header.cz = (VL_Size)VL_MAX((long long)header.cz + 2 * margin, 0);
+	if (!vl_grid_alloc(dst, &header)) {
+		return false;
+	}
+	if (!vl_grid_shift_combine(dst, NULL, src, -margin, -margin, -margin, VL_EBoolUnion)) {
+		vl_grid_free(dst);
+		return false;
+	}
+	return true;
+}
+
+
+/*
+ * EXTERN
+ */
+
+
+_VL_EXTERN_ void vl_vec3_add(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
+	out->x = a->x + b->x;
+	out->y = a->y + b->y;
+	out->z = a->z + b->z;
+}
+
+
+_VL_EXTERN_ void vl_vec3_sub(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
+	out->x = a->x - b->x;
+	out->y = a->y - b->y;
+	out->z = a->z - b->z;
+}
+
+
+_VL_EXTERN_ void vl_vec3_mul(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
+	out->x = a->x * b->x;
+	out->y = a->y * b->y;
+	out->z = a->z * b->z;
+}
+
+
+_VL_EXTERN_ void vl_vec3_div(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
+	out->x = a->x / b->x;
+	out->y = a->y / b->y;
+	out->z = a->z / b->z;
+}
+
+
+_VL_EXTERN_ void vl_vec3_dot(VL_Float * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
+	*out = a->x * b->x + a->y * b->y + a->z * b->z;
+}
+
+
+_VL_EXTERN_ void vl_vec3_dist(VL_Float * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
+	VL_Float px = a->x * a->x;
+	VL_Float py = a->y * a->y;
+	VL_Float pz = a->z * a->z;
+	*out = sqrt(px + py + pz);
+}
+
+
+_VL_EXTERN_ void vl_vec3_cross(VL_Vector3F * out, const VL_Vector3F * const a, const VL_Vector3F * const b) {
+	out->x = a->y * b->z - a->z * b->y;
+	out->y = a->z * b->x - a->x * b->z;
+	out->z = a->x * b->y - a->y * b->x;
+}
+
+
+_VL_EXTERN_ VL_Float vl_volume_from_mesh_desc(
+	_VL_IN_ const VL_MeshDesc * const in_mesh,
+	_VL_IN_ const VL_Float            in_vsize
+	) {
+	VL_MassProperties props;
+	if (!vl_mass_properties_from_mesh_desc(&props, in_mesh, in_vsize)) {
+		return 0.0;
+	}
+	return props.volume;
+}
+
+
+_VL_EXTERN_ VL_Float vl_volume_from_mesh(
+	_VL_IN_ const VL_Vector3F * const in_verts,
+	_VL_IN_ const VL_Size             in_nverts,
+	_VL_IN_ const VL_Size * const     in_faces,
+	_VL_IN_ const VL_Size             in_nfaces,
+	_VL_IN_ const VL_Float            in_vsize
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_volume_from_mesh_desc(&mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ void vl_mesh_from_point_cloud(
+	_VL_OUT_ VL_Vector3F ** const      out_verts,
+	_VL_OUT_ VL_Size * const           out_nverts,
+	_VL_OUT_ VL_Size ** const          out_faces,
+	_VL_OUT_ VL_Size * const           out_nfaces,
+	_VL_IN_  const VL_Vector3F * const in_point_cloud,
+	_VL_IN_  VL_Size                   in_npoints,
+	_VL_IN_  const VL_Float             in_vsize
+	) {
+	VL_Float       halfsize = in_vsize / 2.0;
+	VL_Size       local_nverts = in_npoints * 8;
+	VL_Size       local_nfaces = in_npoints * 12;
+	VL_Vector3F * local_verts  = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * local_nverts);
+	VL_Size *     local_faces  = (VL_Size *)malloc(sizeof(VL_Size) * local_nfaces * 3);
+
+	*out_verts = NULL;
+	*out_nverts = 0;
+	*out_faces = NULL;
+	*out_nfaces = 0;
+	if ((NULL == local_verts) || (NULL == local_faces)) {
+		if (NULL != local_verts) free(local_verts);
+		if (NULL != local_faces) free(local_faces);
+		return;
+	}
+
+	for (VL_Size i = 0; i < in_npoints; i++) {
+		const VL_Vector3F * const point = in_point_cloud + i;
+
+		VL_Vector3F * p0 = local_verts + i * 8 + 0;
+		VL_Vector3F * p1 = p0 + 1;
+		VL_Vector3F * p2 = p1 + 1;
+		VL_Vector3F * p3 = p2 + 1;
+		VL_Vector3F * p4 = p3 + 1;
+		VL_Vector3F * p5 = p4 + 1;
+		VL_Vector3F * p6 = p5 + 1;
+		VL_Vector3F * p7 = p6 + 1;
+
+		p0->x = point->x + halfsize; p0->y = point->y - halfsize; p0->z = point->z + halfsize;
+		p1->x = point->x - halfsize; p1->y = point->y - halfsize; p1->z = point->z + halfsize;
+		p2->x = point->x + halfsize; p2->y = point->y + halfsize; p2->z = point->z + halfsize;
+		p3->x = point->x - halfsize; p3->y = point->y + halfsize; p3->z = point->z + halfsize;
+		p4->x = point->x + halfsize; p4->y = point->y - halfsize; p4->z = point->z - halfsize;
+		p5->x = point->x - halfsize; p5->y = point->y - halfsize; p5->z = point->z - halfsize;
+		p6->x = point->x + halfsize; p6->y = point->y + halfsize; p6->z = point->z - halfsize;
+		p7->x = point->x - halfsize; p7->y = point->y + halfsize; p7->z = point->z - halfsize;
+
+		VL_Size * f0  = local_faces + i * 12 * 3;
+		VL_Size * f1  = f0  + 3;
+		VL_Size * f2  = f1  + 3;
+		VL_Size * f3  = f2  + 3;
+		VL_Size * f4  = f3  + 3;
+		VL_Size * f5  = f4  + 3;
+		VL_Size * f6  = f5  + 3;
+		VL_Size * f7  = f6  + 3;
+		VL_Size * f8  = f7  + 3;
+		VL_Size * f9  = f8  + 3;
+		VL_Size * f10 = f9  + 3;
+		VL_Size * f11 = f10 + 3;
+
+		*f0  = i * 8 + 0; *(f0  + 1) = i * 8 + 1; *(f0  + 2) = i * 8 + 2; // 0 1 2
+		*f1  = i * 8 + 1; *(f1  + 1) = i * 8 + 2; *(f1  + 2) = i * 8 + 3; // 1 2 3
+		*f2  = i * 8 + 4; *(f2  + 1) = i * 8 + 5; *(f2  + 2) = i * 8 + 6; // 4 5 6
+		*f3  = i * 8 + 5; *(f3  + 1) = i * 8 + 6; *(f3  + 2) = i * 8 + 7; // 5 6 7
+		*f4  = i * 8 + 0; *(f4  + 1) = i * 8 + 1; *(f4  + 2) = i * 8 + 4; // 0 1 4
+		*f5  = i * 8 + 1; *(f5  + 1) = i * 8 + 4; *(f5  + 2) = i * 8 + 5; // 1 4 5
+		*f6  = i * 8 + 2; *(f6  + 1) = i * 8 + 3; *(f6  + 2) = i * 8 + 6; // 2 3 6
+		*f7  = i * 8 + 3; *(f7  + 1) = i * 8 + 6; *(f7  + 2) = i * 8 + 7; // 3 6 7
+		*f8  = i * 8 + 1; *(f8  + 1) = i * 8 + 3; *(f8  + 2) = i * 8 + 5; // 1 3 5
+		*f9  = i * 8 + 3; *(f9  + 1) = i * 8 + 5; *(f9  + 2) = i * 8 + 7; // 3 5 7
+		*f10 = i * 8 + 0; *(f10 + 1) = i * 8 + 2; *(f10 + 2) = i * 8 + 4; // 0 2 4
+		*f11 = i * 8 + 2; *(f11 + 1) = i * 8 + 4; *(f11 + 2) = i * 8 + 6; // 2 4 6
+
+	}
+	*out_nverts = local_nverts;
+	*out_nfaces = local_nfaces;
+	*out_verts  = local_verts;
+	*out_faces  = local_faces;
+}
+
+
 _VL_EXTERN_ void vl_point_cloud_res_from_mesh(
 	_VL_OPT_OUT_ VL_Size *                 out_cx,
 	_VL_OPT_OUT_ VL_Size *                 out_cy,
@@ -492,231 +3506,1209 @@ _VL_EXTERN_ void vl_point_cloud_res_from_mesh(
 }
 
 
-_VL_EXTERN_ void vl_point_cloud_res_from_bbox(
-	_VL_OUT_ VL_Size *                out_cx,
-	_VL_OUT_ VL_Size *                out_cy,
-	_VL_OUT_ VL_Size *                out_cz,
-	_VL_IN_ const VL_Vector3F * const in_vmin,
-	_VL_IN_ const VL_Vector3F * const in_vmax,
-	_VL_IN_ const VL_Float            in_vsize
+_VL_EXTERN_ void vl_point_cloud_res_from_bbox(
+	_VL_OUT_ VL_Size *                out_cx,
+	_VL_OUT_ VL_Size *                out_cy,
+	_VL_OUT_ VL_Size *                out_cz,
+	_VL_IN_ const VL_Vector3F * const in_vmin,
+	_VL_IN_ const VL_Vector3F * const in_vmax,
+	_VL_IN_ const VL_Float            in_vsize
+	) {
+	// Checked before casting, out of range doubles can not be converted to VL_Size
+	if (vl_is_grid_overflowed(in_vmin, in_vmax, 0, in_vsize)) {
+		*out_cx = 0;
+		*out_cy = 0;
+		*out_cz = 0;
+		return;
+	}
+	*out_cx = (VL_Size)VL_MAX((ceil((in_vmax->x - in_vmin->x) / in_vsize)), 1);
+	*out_cy = (VL_Size)VL_MAX((ceil((in_vmax->y - in_vmin->y) / in_vsize)), 1);
+	*out_cz = (VL_Size)VL_MAX((ceil((in_vmax->z - in_vmin->z) / in_vsize)), 1);
+}
+
+
+_VL_EXTERN_ VL_Vector3F * vl_point_cloud_from_mesh_desc(
+	_VL_OPT_OUT_ VL_Vector3F ** const      out_point_cloud,
+	_VL_OUT_     VL_Size * const           out_npoints,
+	_VL_IN_      const VL_MeshDesc * const in_mesh,
+	_VL_IN_      const VL_Float            in_vsize
+	) {
+	// Half of voxel's size
+	const VL_Float halfsize = in_vsize / 2.0;
+	// Projection masks in X, Y, Z direction
+	VL_ProjMasks masks;
+	// Integer common counter
+	VL_Size counter = 0;
+	// Output point cloud
+	VL_Vector3F * temp_point_cloud;
+
+	// Reset out_npoints to 0 and out_point_cloud to NULL
+	*out_npoints = 0;
+	if (out_point_cloud) { *out_point_cloud = NULL; }
+
+	if (!vl_proj_masks_from_mesh(&masks, in_mesh, in_vsize)) {
+		return NULL;
+	}
+
+	// Accumulate hit voxel count for point cloud memmory allocation
+	*out_npoints = vl_proj_masks_count(&masks);
+	// Allocate memmory for point cloud
+	temp_point_cloud = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * (*out_npoints));
+	if (NULL == temp_point_cloud) {
+		vl_proj_masks_free(&masks);
+		*out_npoints = 0;
+		return NULL;
+	}
+	for (VL_Size x = 0; x < masks.cx; x++) {
+		for (VL_Size y = 0; y < masks.cy; y++) {
+			for (VL_Size z = 0; z < masks.cz; z++) {
+				if (vl_proj_masks_hit(&masks, x, y, z)) {
+					(temp_point_cloud + counter)->x = x * in_vsize + halfsize + masks.vmin.x;
+					(temp_point_cloud + counter)->y = y * in_vsize + halfsize + masks.vmin.y;
+					(temp_point_cloud + counter)->z = z * in_vsize + halfsize + masks.vmin.z;
+					counter++;
+				}
+			}
+		}
+	}
+
+	vl_proj_masks_free(&masks);
+
+	if (out_point_cloud) { *out_point_cloud = temp_point_cloud; }
+	return temp_point_cloud;
+}
+
+
+_VL_EXTERN_ uint64_t vl_morton_encode(
+	_VL_IN_ const VL_Size in_x,
+	_VL_IN_ const VL_Size in_y,
+	_VL_IN_ const VL_Size in_z
+	) {
+	return vl_morton_spread((uint64_t)in_x) | (vl_morton_spread((uint64_t)in_y) << 1) | (vl_morton_spread((uint64_t)in_z) << 2);
+}
+
+
+_VL_EXTERN_ void vl_morton_decode(
+	_VL_OUT_ VL_Size * const out_x,
+	_VL_OUT_ VL_Size * const out_y,
+	_VL_OUT_ VL_Size * const out_z,
+	_VL_IN_  const uint64_t  in_key
+	) {
+	*out_x = (VL_Size)vl_morton_compact(in_key);
+	*out_y = (VL_Size)vl_morton_compact(in_key >> 1);
+	*out_z = (VL_Size)vl_morton_compact(in_key >> 2);
+}
+
+
+_VL_EXTERN_ void vl_point_from_morton(
+	_VL_OUT_ VL_Vector3F * const          out_point,
+	_VL_IN_  const VL_VoxelHeader * const in_header,
+	_VL_IN_  const uint64_t               in_key
+	) {
+	VL_Size x, y, z;
+	const VL_Float halfsize = in_header->vsize / 2.0;
+	vl_morton_decode(&x, &y, &z, in_key);
+	out_point->x = x * in_header->vsize + halfsize + in_header->origin.x;
+	out_point->y = y * in_header->vsize + halfsize + in_header->origin.y;
+	out_point->z = z * in_header->vsize + halfsize + in_header->origin.z;
+}
+
+
+_VL_EXTERN_ uint64_t * vl_morton_from_mesh_desc(
+	_VL_OPT_OUT_ uint64_t ** const         out_keys,
+	_VL_OUT_     VL_Size * const           out_nkeys,
+	_VL_OUT_     VL_VoxelHeader * const    out_header,
+	_VL_IN_      const VL_MeshDesc * const in_mesh,
+	_VL_IN_      const VL_Float            in_vsize
+	) {
+	VL_ProjMasks masks;
+	VL_Size counter = 0;
+	unsigned int nbits = 0;
+	uint64_t * temp_keys;
+
+	*out_nkeys = 0;
+	if (out_keys) { *out_keys = NULL; }
+	memset(out_header, 0, sizeof(VL_VoxelHeader));
+
+	if (!vl_proj_masks_from_mesh(&masks, in_mesh, in_vsize)) {
+		return NULL;
+	}
+	// Each axis has 21 bits in a 64 bit key
+	if ((masks.cx > VL_MORTON_MAX_RES) || (masks.cy > VL_MORTON_MAX_RES) || (masks.cz > VL_MORTON_MAX_RES)) {
+		vl_proj_masks_free(&masks);
+		return NULL;
+	}
+	out_header->origin = masks.vmin;
+	out_header->vsize  = in_vsize;
+	out_header->cx     = masks.cx;
+	out_header->cy     = masks.cy;
+	out_header->cz     = masks.cz;
+
+	*out_nkeys = vl_proj_masks_count(&masks);
+	temp_keys = (uint64_t *)malloc(sizeof(uint64_t) * (*out_nkeys));
+	if (NULL == temp_keys) {
+		vl_proj_masks_free(&masks);
+		*out_nkeys = 0;
+		return NULL;
+	}
+	for (VL_Size x = 0; x < masks.cx; x++) {
+		for (VL_Size y = 0; y < masks.cy; y++) {
+			for (VL_Size z = 0; z < masks.cz; z++) {
+				if (vl_proj_masks_hit(&masks, x, y, z)) {
+					temp_keys[counter++] = vl_morton_encode(x, y, z);
+				}
+			}
+		}
+	}
+	vl_proj_masks_free(&masks);
+
+	// Only sort bits which may be set
+	while (((VL_Size)1 << nbits) < VL_MAX(VL_MAX(out_header->cx, out_header->cy), out_header->cz)) {
+		nbits++;
+	}
+	if (!vl_radix_sort_u64(temp_keys, NULL, *out_nkeys, nbits * 3)) {
+		free(temp_keys);
+		*out_nkeys = 0;
+		return NULL;
+	}
+
+	if (out_keys) { *out_keys = temp_keys; }
+	return temp_keys;
+}
+
+
+_VL_EXTERN_ bool vl_plan_from_mesh_desc(
+	_VL_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_PlanStats stats;
+
+	memset(out_plan, 0, sizeof(VL_Plan));
+	if (!vl_mesh_desc_is_valid(in_mesh) || !vl_plan_stats_from_mesh(&stats, in_mesh)) {
+		return false;
+	}
+	return vl_plan_from_stats(out_plan, &stats, in_vsize);
+}
+
+
+_VL_EXTERN_ VL_Float vl_plan_vsize_from_budget_desc(
+	_VL_OPT_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_      const VL_MeshDesc * const in_mesh,
+	_VL_IN_      const double              in_max_bytes,
+	_VL_IN_      const double              in_max_work
+	) {
+	VL_PlanStats stats;
+	VL_Plan plan;
+	double extent, lo, hi;
+
+	if (out_plan) { memset(out_plan, 0, sizeof(VL_Plan)); }
+	if (!vl_mesh_desc_is_valid(in_mesh) || !vl_plan_stats_from_mesh(&stats, in_mesh)) {
+		return 0.0;
+	}
+	extent = VL_MAX(VL_MAX(stats.vmax.x - stats.vmin.x, stats.vmax.y - stats.vmin.y), stats.vmax.z - stats.vmin.z);
+	if (!(extent > 0.0)) {
+		return 0.0;
+	}
+
+	// Coarsest grid is a single voxel, if even that does not fit there is no answer
+	hi = extent;
+	if (!vl_plan_from_stats(&plan, &stats, hi) ||
+		(plan.peak_bytes > in_max_bytes) ||
+		((in_max_work > 0.0) && (plan.work > in_max_work))) {
+		return 0.0;
+	}
+	// Bisect voxel size in log space, cost only grows as voxels get smaller
+	lo = extent * 1e-9;
+	for (int i = 0; i < 64; i++) {
+		double mid = sqrt(lo * hi);
+		if (vl_plan_from_stats(&plan, &stats, mid) &&
+			(plan.peak_bytes <= in_max_bytes) &&
+			((in_max_work <= 0.0) || (plan.work <= in_max_work))) {
+			hi = mid;
+		} else {
+			lo = mid;
+		}
+	}
+	if (out_plan) { vl_plan_from_stats(out_plan, &stats, hi); }
+	return hi;
+}
+
+
+_VL_EXTERN_ bool vl_svo_from_mesh_desc(
+	_VL_OUT_ VL_Svo * const            out_svo,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_ProjMasks masks;
+	VL_ProjSums sums;
+	VL_SvoNodeArray arr;
+	VL_SvoNodeArray * task_arrs;
+	VL_SvoKind * task_kinds;
+	VL_SvoNode * task_nodes;
+	VL_SvoNode root;
+	VL_Size res, ntasks_axis, ntasks, task_size;
+	uint32_t depth = 0, task_depth;
+	bool failed = false;
+
+	memset(out_svo, 0, sizeof(VL_Svo));
+	if (!vl_proj_masks_from_mesh(&masks, in_mesh, in_vsize)) {
+		return false;
+	}
+	if (!vl_proj_sums_build(&sums, &masks)) {
+		vl_proj_masks_free(&masks);
+		return false;
+	}
+	res = VL_MAX(VL_MAX(masks.cx, masks.cy), masks.cz);
+	while (((VL_Size)1 << depth) < res) {
+		depth++;
+	}
+
+	// Split grid into up to 64 subtrees built in parallel, then link levels above them
+	task_depth  = VL_MIN(depth, 2);
+	ntasks_axis = (VL_Size)1 << task_depth;
+	ntasks      = ntasks_axis * ntasks_axis * ntasks_axis;
+	task_size   = (VL_Size)1 << (depth - task_depth);
+	task_arrs   = (VL_SvoNodeArray *)calloc(ntasks, sizeof(VL_SvoNodeArray));
+	task_kinds  = (VL_SvoKind *)malloc(sizeof(VL_SvoKind) * ntasks);
+	task_nodes  = (VL_SvoNode *)malloc(sizeof(VL_SvoNode) * ntasks);
+	if ((NULL == task_arrs) || (NULL == task_kinds) || (NULL == task_nodes)) {
+		free(task_arrs);
+		free(task_kinds);
+		free(task_nodes);
+		vl_proj_sums_free(&sums);
+		vl_proj_masks_free(&masks);
+		return false;
+	}
+	#pragma omp parallel for schedule(dynamic)
+	for (long t = 0; t < (long)ntasks; t++) {
+		VL_Size bx = (VL_Size)t % ntasks_axis;
+		VL_Size by = ((VL_Size)t / ntasks_axis) % ntasks_axis;
+		VL_Size bz = (VL_Size)t / (ntasks_axis * ntasks_axis);
+		task_kinds[t] = vl_svo_build_block(task_nodes + t, task_arrs + t, &masks, &sums,
+				bx * task_size, by * task_size, bz * task_size, task_size);
+	}
+
+	// Relocate subtrees into one array
+	memset(&arr, 0, sizeof(VL_SvoNodeArray));
+	for (VL_Size t = 0; t < ntasks; t++) {
+		uint32_t offset = arr.n;
+		failed = failed || task_arrs[t].failed;
+		for (uint32_t i = 0; !failed && (i < task_arrs[t].n); i++) {
+			VL_SvoNode node = task_arrs[t].data[i];
+			node.child += offset;
+			vl_svo_node_push(&arr, &node);
+		}
+		if (task_kinds[t] == VL_ESvoMixed) {
+			task_nodes[t].child += offset;
+		}
+		free(task_arrs[t].data);
+	}
+	if (!failed) {
+		switch (vl_svo_link_block(&root, &arr, task_kinds, task_nodes, ntasks_axis, 0, 0, 0, ntasks_axis)) {
+			case VL_ESvoEmpty: out_svo->root = VL_SVO_EMPTY; break;
+			case VL_ESvoFull:  out_svo->root = VL_SVO_FULL;  break;
+			case VL_ESvoMixed: out_svo->root = vl_svo_node_push(&arr, &root); break;
+		}
+	}
+	free(task_arrs);
+	free(task_kinds);
+	free(task_nodes);
+	vl_proj_sums_free(&sums);
+	if (failed || arr.failed) {
+		free(arr.data);
+		vl_proj_masks_free(&masks);
+		memset(out_svo, 0, sizeof(VL_Svo));
+		return false;
+	}
+
+	out_svo->header.origin = masks.vmin;
+	out_svo->header.vsize  = in_vsize;
+	out_svo->header.cx     = masks.cx;
+	out_svo->header.cy     = masks.cy;
+	out_svo->header.cz     = masks.cz;
+	out_svo->depth         = depth;
+	out_svo->nnodes        = arr.n;
+	out_svo->nodes         = arr.data;
+	vl_proj_masks_free(&masks);
+	return true;
+}
+
+
+_VL_EXTERN_ void vl_svo_free(VL_Svo * const svo) {
+	free(svo->nodes);
+	memset(svo, 0, sizeof(VL_Svo));
+}
+
+
+_VL_EXTERN_ bool vl_svo_lookup(
+	_VL_IN_ const VL_Svo * const svo,
+	_VL_IN_ const VL_Size        in_x,
+	_VL_IN_ const VL_Size        in_y,
+	_VL_IN_ const VL_Size        in_z
+	) {
+	uint32_t node = svo->root;
+	if ((in_x >= svo->header.cx) || (in_y >= svo->header.cy) || (in_z >= svo->header.cz)) {
+		return false;
+	}
+	if (node == VL_SVO_EMPTY || node == VL_SVO_FULL) {
+		return node == VL_SVO_FULL;
+	}
+	for (uint32_t level = svo->depth; level > 0; level--) {
+		const VL_SvoNode * n = svo->nodes + node;
+		int i = (int)(((in_x >> (level - 1)) & 1) | (((in_y >> (level - 1)) & 1) << 1) | (((in_z >> (level - 1)) & 1) << 2));
+		if (n->full & (1 << i)) {
+			return true;
+		}
+		if (!(n->mixed & (1 << i))) {
+			return false;
+		}
+		node = n->child;
+		for (int j = 0; j < i; j++) {
+			if (n->mixed & (1 << j)) { node++; }
+		}
+	}
+	return false;
+}
+
+
+_VL_EXTERN_ bool vl_svo_raycast(
+	_VL_OUT_ VL_Float * const          out_t,
+	_VL_IN_  const VL_Svo * const      svo,
+	_VL_IN_  const VL_Vector3F * const in_origin,
+	_VL_IN_  const VL_Vector3F * const in_dir
+	) {
+	// Trace in voxel units where the root spans [0, 2^depth)
+	const VL_Float origin[3] = {
+		(in_origin->x - svo->header.origin.x) / svo->header.vsize,
+		(in_origin->y - svo->header.origin.y) / svo->header.vsize,
+		(in_origin->z - svo->header.origin.z) / svo->header.vsize,
+	};
+	const VL_Float inv_dir[3] = {
+		svo->header.vsize / in_dir->x,
+		svo->header.vsize / in_dir->y,
+		svo->header.vsize / in_dir->z,
+	};
+	const VL_Size s = (VL_Size)1 << svo->depth;
+	VL_Float t0, t1;
+
+	if (svo->root == VL_SVO_EMPTY) {
+		return false;
+	}
+	if (svo->root == VL_SVO_FULL) {
+		if (!vl_svo_ray_block(&t0, &t1, 0, 0, 0, s, origin, inv_dir, 0.0, INFINITY)) {
+			return false;
+		}
+		*out_t = t0;
+		return true;
+	}
+	if (!vl_svo_ray_block(&t0, &t1, 0, 0, 0, s, origin, inv_dir, 0.0, INFINITY)) {
+		return false;
+	}
+	return vl_svo_raycast_node(svo, svo->root, 0, 0, 0, s, origin, inv_dir, t0, t1, out_t);
+}
+
+
+_VL_EXTERN_ bool vl_write_mesh_from_point_cloud(
+	_VL_IN_ const int                 in_fd,
+	_VL_IN_ const VL_MeshFormat       in_format,
+	_VL_IN_ const VL_Vector3F * const in_point_cloud,
+	_VL_IN_ const VL_Size             in_npoints,
+	_VL_IN_ const VL_Float            in_vsize
+	) {
+	const VL_Float halfsize = in_vsize / 2.0;
+	VL_FdWriter writer;
+	bool ok = false;
+
+	writer.fd = in_fd;
+	writer.n = 0;
+	writer.failed = false;
+	writer.buf = (char *)malloc(VL_WRITER_BUFLEN);
+	if (NULL == writer.buf) {
+		return false;
+	}
+	switch (in_format) {
+		case VL_EFormatObj:
+			vl_write_obj(&writer, in_point_cloud, in_npoints, halfsize);
+			ok = true;
+			break;
+		case VL_EFormatPly:
+			ok = vl_write_ply(&writer, in_point_cloud, in_npoints, halfsize);
+			break;
+		case VL_EFormatStl:
+			ok = vl_write_stl(&writer, in_point_cloud, in_npoints, halfsize);
+			break;
+	}
+	vl_writer_flush(&writer);
+	free(writer.buf);
+	return ok && !writer.failed;
+}
+
+
+_VL_EXTERN_ VL_Vector3F * vl_point_cloud_from_mesh(
+	_VL_OPT_OUT_ VL_Vector3F ** const      out_point_cloud,
+	_VL_OUT_     VL_Size * const           out_npoints,
+	_VL_IN_      const VL_Vector3F * const in_verts,
+	_VL_IN_      const VL_Size             in_nverts,
+	_VL_IN_      const VL_Size * const     in_faces,
+	_VL_IN_      const VL_Size             in_nfaces,
+	_VL_IN_      const VL_Float            in_vsize
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_point_cloud_from_mesh_desc(out_point_cloud, out_npoints, &mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ uint64_t * vl_morton_from_mesh(
+	_VL_OPT_OUT_ uint64_t ** const         out_keys,
+	_VL_OUT_     VL_Size * const           out_nkeys,
+	_VL_OUT_     VL_VoxelHeader * const    out_header,
+	_VL_IN_      const VL_Vector3F * const in_verts,
+	_VL_IN_      const VL_Size             in_nverts,
+	_VL_IN_      const VL_Size * const     in_faces,
+	_VL_IN_      const VL_Size             in_nfaces,
+	_VL_IN_      const VL_Float            in_vsize
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_morton_from_mesh_desc(out_keys, out_nkeys, out_header, &mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ bool vl_plan_from_mesh(
+	_VL_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_plan_from_mesh_desc(out_plan, &mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ VL_Float vl_plan_vsize_from_budget(
+	_VL_OPT_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_      const VL_Vector3F * const in_verts,
+	_VL_IN_      const VL_Size             in_nverts,
+	_VL_IN_      const VL_Size * const     in_faces,
+	_VL_IN_      const VL_Size             in_nfaces,
+	_VL_IN_      const double              in_max_bytes,
+	_VL_IN_      const double              in_max_work
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_plan_vsize_from_budget_desc(out_plan, &mesh, in_max_bytes, in_max_work);
+}
+
+
+_VL_EXTERN_ bool vl_svo_from_mesh(
+	_VL_OUT_ VL_Svo * const            out_svo,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
 	) {
-	*out_cx = (VL_Size)VL_MAX((ceil((in_vmax->x - in_vmin->x) / in_vsize)), 1);
-	*out_cy = (VL_Size)VL_MAX((ceil((in_vmax->y - in_vmin->y) / in_vsize)), 1);
-	*out_cz = (VL_Size)VL_MAX((ceil((in_vmax->z - in_vmin->z) / in_vsize)), 1);
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_svo_from_mesh_desc(out_svo, &mesh, in_vsize);
 }
 
 
-_VL_EXTERN_ VL_Vector3F * vl_point_cloud_from_mesh(
-	_VL_OUT_ VL_Vector3F ** const      out_point_cloud,
-	_VL_OUT_ VL_Size * const           out_npoints,
+_VL_EXTERN_ bool vl_grid_from_mesh_desc(
+	_VL_OUT_ VL_VoxelGrid * const      out_grid,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_ProjMasks masks;
+	bool ok;
+
+	memset(out_grid, 0, sizeof(VL_VoxelGrid));
+	if (!vl_proj_masks_from_mesh(&masks, in_mesh, in_vsize)) {
+		return false;
+	}
+	ok = vl_grid_from_masks(out_grid, &masks, in_vsize);
+	vl_proj_masks_free(&masks);
+	return ok;
+}
+
+
+_VL_EXTERN_ bool vl_grid_from_mesh(
+	_VL_OUT_ VL_VoxelGrid * const      out_grid,
 	_VL_IN_  const VL_Vector3F * const in_verts,
 	_VL_IN_  const VL_Size             in_nverts,
 	_VL_IN_  const VL_Size * const     in_faces,
 	_VL_IN_  const VL_Size             in_nfaces,
 	_VL_IN_  const VL_Float            in_vsize
 	) {
-	// Voxel's bounding box and center
-	VL_Vector3F vmin, vmax, vcenter;
-	// Half of voxel's size
-	const VL_Float halfsize = in_vsize / 2.0;
-	// Count of mesh's division in X, Y, Z dimensions fron voxel
-	VL_Size cx, cy, cz;
-	// Project plane buff which is used to store hit flag
-	bool * buff_front, * buff_left, * buff_top;
-	// Pre Projected in_verts in X, Y, Z dimension
-	VL_Vector3F * verts_front, * verts_left, * verts_top;
-	// Integer common counter
-	VL_Size counter = 0;
-	// IDX from X, Y, Z project plane
-	VL_Size id_front, id_left, id_top;
-	// Output point cloud
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_grid_from_mesh_desc(out_grid, &mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ void vl_grid_free(VL_VoxelGrid * const grid) {
+	free(grid->bits);
+	memset(grid, 0, sizeof(VL_VoxelGrid));
+}
+
+
+_VL_EXTERN_ bool vl_grid_get(const VL_VoxelGrid * const grid, const VL_Size in_x, const VL_Size in_y, const VL_Size in_z) {
+	if ((in_x >= grid->header.cx) || (in_y >= grid->header.cy) || (in_z >= grid->header.cz)) {
+		return false;
+	}
+	return (vl_grid_row(grid, in_y, in_z)[in_x / 64] >> (in_x % 64)) & 1;
+}
+
+
+_VL_EXTERN_ VL_Size vl_grid_count(const VL_VoxelGrid * const grid) {
+	const VL_Size nwords = grid->nwords * grid->header.cy * grid->header.cz;
+	VL_Size count = 0;
+	for (VL_Size k = 0; k < nwords; k++) {
+		count += (VL_Size)vl_popcount64(grid->bits[k]);
+	}
+	return count;
+}
+
+
+_VL_EXTERN_ VL_Vector3F * vl_point_cloud_from_grid(
+	_VL_OPT_OUT_ VL_Vector3F ** const       out_point_cloud,
+	_VL_OUT_     VL_Size * const            out_npoints,
+	_VL_IN_      const VL_VoxelGrid * const in_grid
+	) {
+	const VL_VoxelHeader * h = &in_grid->header;
+	const VL_Float halfsize = h->vsize / 2.0;
 	VL_Vector3F * temp_point_cloud;
+	VL_Size counter = 0;
 
-	// Reset out_npoints to 0 and out_point_cloud to NULL
 	*out_npoints = 0;
 	if (out_point_cloud) { *out_point_cloud = NULL; }
-
-	// Return NULL if no in_verts
-	if (in_nverts == 0 || in_nfaces == 0) {
+	// One spare point so an empty grid still gets a valid pointer rather than malloc(0)
+	temp_point_cloud = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * (vl_grid_count(in_grid) + 1));
+	if (NULL == temp_point_cloud) {
 		return NULL;
 	}
+	for (VL_Size z = 0; z < h->cz; z++) {
+		for (VL_Size y = 0; y < h->cy; y++) {
+			const uint64_t * row = vl_grid_row(in_grid, y, z);
+			for (VL_Size w = 0; w < in_grid->nwords; w++) {
+				uint64_t bits = row[w];
+				while (bits) {
+					VL_Size x = w * 64 + (VL_Size)vl_ctz64(bits);
+					bits &= bits - 1;
+					temp_point_cloud[counter].x = x * h->vsize + halfsize + h->origin.x;
+					temp_point_cloud[counter].y = y * h->vsize + halfsize + h->origin.y;
+					temp_point_cloud[counter].z = z * h->vsize + halfsize + h->origin.z;
+					counter++;
+				}
+			}
+		}
+	}
+	*out_npoints = counter;
+	if (out_point_cloud) { *out_point_cloud = temp_point_cloud; }
+	return temp_point_cloud;
+}
 
-	// Calculate voxel's bounding box and mash division in X, Y, Z direction
-	vl_point_cloud_res_from_mesh(&cx, &cy, &cz, &vmin, &vmax, in_verts, in_nverts, in_vsize);
 
-	// Allocate X, Y, Z project plane to store hit flag
-	buff_front = (bool *)malloc(sizeof(bool) * cx * cz);
-	buff_left  = (bool *)malloc(sizeof(bool) * cy * cz);
-	buff_top   = (bool *)malloc(sizeof(bool) * cx * cy);
-	if ((NULL == buff_front) || (NULL == buff_left) || (NULL == buff_top)) {
-		if (NULL != buff_front) free(buff_front);
-		if (NULL != buff_left) free(buff_left);
-		if (NULL != buff_top) free(buff_top);
-		*out_npoints = 0;
-		if (out_point_cloud) { *out_point_cloud = NULL; }
-		return NULL;
+_VL_EXTERN_ bool vl_grid_boolean(
+	_VL_OUT_ VL_VoxelGrid * const       out_grid,
+	_VL_IN_  const VL_VoxelGrid * const in_a,
+	_VL_IN_  const VL_VoxelGrid * const in_b,
+	_VL_IN_  const VL_BoolOp            in_op
+	) {
+	long long lo[3], hi[3], offset[3];
+	VL_VoxelHeader header;
+	bool failed = false;
+
+	memset(out_grid, 0, sizeof(VL_VoxelGrid));
+	if (!vl_grid_boolean_frame(lo, hi, offset, in_a, in_b, in_op)) {
+		return false;
 	}
-	memset(buff_front, 0, sizeof(bool) * cx * cz);
-	memset(buff_left,  0, sizeof(bool) * cy * cz);
-	memset(buff_top,   0, sizeof(bool) * cx * cy);
-
-	// Pre project in_verts into X, Y, Z project plane
-	verts_front = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * in_nverts);
-	verts_left  = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * in_nverts);
-	verts_top   = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * in_nverts);
-	if ((NULL == verts_front) || (NULL == verts_left) || (NULL == verts_top)) {
-		if (NULL != buff_front) free(buff_front);
-		if (NULL != buff_left) free(buff_left);
-		if (NULL != buff_top) free(buff_top);
-		if (NULL != verts_front) free(verts_front);
-		if (NULL != verts_left) free(verts_left);
-		if (NULL != verts_top) free(verts_top);
-		*out_npoints = 0;
-		if (out_point_cloud) { *out_point_cloud = NULL; }
-		return NULL;
+	header.vsize    = in_a->header.vsize;
+	header.origin.x = in_a->header.origin.x + lo[0] * header.vsize;
+	header.origin.y = in_a->header.origin.y + lo[1] * header.vsize;
+	header.origin.z = in_a->header.origin.z + lo[2] * header.vsize;
+	header.cx       = (VL_Size)(hi[0] - lo[0]);
+	header.cy       = (VL_Size)(hi[1] - lo[1]);
+	header.cz       = (VL_Size)(hi[2] - lo[2]);
+	if (!vl_grid_alloc(out_grid, &header)) {
+		return false;
 	}
-	for (VL_Size i = 0; i < in_nverts; i++) {
-		vl_proj_vert_front(verts_front + i, in_verts + i);
-		vl_proj_vert_left (verts_left  + i, in_verts + i);
-		vl_proj_vert_top  (verts_top   + i, in_verts + i);
-	}
-
-	// Trace Front
-	for (VL_Size z = 0; z < cz; z++) {
-		for (VL_Size x = 0; x < cx; x++) {
-			int hit;
-			vcenter.x = x * in_vsize + vmin.x;
-			vcenter.y = 0.0;
-			vcenter.z = z * in_vsize + vmin.z;
-			vl_proj_vert_front(&vcenter, &vcenter);
-			for (VL_Size f = 0; f < in_nfaces; f++) {
-				VL_Size idx = in_faces[f * 3 + 0];
-				VL_Size idy = in_faces[f * 3 + 1];
-				VL_Size idz = in_faces[f * 3 + 2];
-				hit = vl_is_voxel_tri_intersected_proj(
-						VL_EProjectNone,
-						verts_front + idx,
-						verts_front + idy,
-						verts_front + idz,
-						&vcenter,
-						in_vsize
-						);
-				if (hit) {
-					buff_front[z * cx + x] = hit;
-					break;
+	#pragma omp parallel
+	{
+		uint64_t * rb = (uint64_t *)malloc(sizeof(uint64_t) * (out_grid->nwords + 1));
+		if (NULL == rb) {
+			#pragma omp atomic write
+			failed = true;
+		}
+		#pragma omp for schedule(static)
+		for (long z = 0; z < (long)header.cz; z++) {
+			for (VL_Size y = 0; (y < header.cy) && (NULL != rb); y++) {
+				uint64_t * row = vl_grid_row(out_grid, y, (VL_Size)z);
+				long long ay = lo[1] + (long long)y, az = lo[2] + z;
+				vl_grid_row_extract(row, in_a, lo[0], ay, az, out_grid->nwords);
+				vl_grid_row_extract(rb, in_b, lo[0] - offset[0], ay - offset[1], az - offset[2], out_grid->nwords);
+				vl_grid_row_combine(row, rb, out_grid->nwords, in_op);
+				// Keep bits past cx clear
+				if (header.cx % 64) {
+					row[out_grid->nwords - 1] &= ((uint64_t)1 << (header.cx % 64)) - 1;
 				}
 			}
 		}
+		free(rb);
+	}
+	if (failed) {
+		vl_grid_free(out_grid);
+		return false;
 	}
+	return true;
+}
 
-	// Trace Left
-	for (VL_Size z = 0; z < cz; z++) {
-		for (VL_Size y = 0; y < cy; y++) {
-			int hit;
-			vcenter.x = 0.0;
-			vcenter.y = y * in_vsize + vmin.y;
-			vcenter.z = z * in_vsize + vmin.z;
-			vl_proj_vert_left(&vcenter, &vcenter);
-			for (VL_Size f = 0; f < in_nfaces; f++) {
-				VL_Size idx = in_faces[f * 3 + 0];
-				VL_Size idy = in_faces[f * 3 + 1];
-				VL_Size idz = in_faces[f * 3 + 2];
-				hit = vl_is_voxel_tri_intersected_proj(
-						VL_EProjectNone,
-						verts_left + idx,
-						verts_left + idy,
-						verts_left + idz,
-						&vcenter,
-						in_vsize
-						);
-				if (hit) {
-					buff_left[z * cy + y] = hit;
-					break;
+
+_VL_EXTERN_ bool vl_grid_boolean_count(
+	_VL_OUT_ VL_Size * const            out_count,
+	_VL_IN_  const VL_VoxelGrid * const in_a,
+	_VL_IN_  const VL_VoxelGrid * const in_b,
+	_VL_IN_  const VL_BoolOp            in_op
+	) {
+	long long lo[3], hi[3], offset[3];
+	VL_Size nwords, count = 0;
+	unsigned int bits, nfailed = 0;
+	uint64_t tail;
+
+	*out_count = 0;
+	if (!vl_grid_boolean_frame(lo, hi, offset, in_a, in_b, in_op)) {
+		return false;
+	}
+	nwords = vl_grid_row_words((VL_Size)(hi[0] - lo[0]));
+	bits = (unsigned int)((hi[0] - lo[0]) % 64);
+	tail = bits ? (((uint64_t)1 << bits) - 1) : ~(uint64_t)0;
+	#pragma omp parallel reduction(+:count, nfailed)
+	{
+		uint64_t * ra = (uint64_t *)malloc(sizeof(uint64_t) * (nwords + 1));
+		uint64_t * rb = (uint64_t *)malloc(sizeof(uint64_t) * (nwords + 1));
+		// Rows of this thread would be skipped, so the whole count is void
+		if ((NULL == ra) || (NULL == rb)) {
+			nfailed++;
+		}
+		#pragma omp for schedule(static)
+		for (long long z = lo[2]; z < hi[2]; z++) {
+			for (long long y = lo[1]; (y < hi[1]) && (NULL != ra) && (NULL != rb); y++) {
+				vl_grid_row_extract(ra, in_a, lo[0], y, z, nwords);
+				vl_grid_row_extract(rb, in_b, lo[0] - offset[0], y - offset[1], z - offset[2], nwords);
+				vl_grid_row_combine(ra, rb, nwords, in_op);
+				if (nwords > 0) {
+					ra[nwords - 1] &= tail;
+				}
+				for (VL_Size k = 0; k < nwords; k++) {
+					count += (VL_Size)vl_popcount64(ra[k]);
 				}
 			}
 		}
+		free(ra);
+		free(rb);
+	}
+	if (nfailed > 0) {
+		return false;
+	}
+	*out_count = count;
+	return true;
+}
+
+
+_VL_EXTERN_ bool vl_mass_properties_from_mesh_desc(
+	_VL_OUT_ VL_MassProperties * const out_props,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_ProjMasks masks;
+	bool ok;
+
+	memset(out_props, 0, sizeof(VL_MassProperties));
+	if (!vl_proj_masks_from_mesh(&masks, in_mesh, in_vsize)) {
+		return false;
+	}
+	ok = vl_mass_properties_from_masks(out_props, &masks, in_vsize);
+	vl_proj_masks_free(&masks);
+	return ok;
+}
+
+
+_VL_EXTERN_ bool vl_mass_properties_from_mesh(
+	_VL_OUT_ VL_MassProperties * const out_props,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_mass_properties_from_mesh_desc(out_props, &mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ bool vl_mesh_prepare_desc(
+	_VL_OUT_ VL_Mesh * const           out_mesh,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_weld_tol
+	) {
+	VL_Vector3F vmin, vmax;
+	VL_Vector3F * verts;
+	VL_Size * remap, * faces, nfaces = in_mesh->nfaces, nverts = 0;
+
+	memset(out_mesh, 0, sizeof(VL_Mesh));
+	if (!vl_mesh_desc_is_valid(in_mesh)) {
+		return false;
+	}
+	verts = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * in_mesh->nverts);
+	remap = (VL_Size *)malloc(sizeof(VL_Size) * in_mesh->nverts);
+	faces = (VL_Size *)malloc(sizeof(VL_Size) * in_mesh->nfaces * 3);
+	if ((NULL == verts) || (NULL == remap) || (NULL == faces)) {
+		free(verts);
+		free(remap);
+		free(faces);
+		return false;
+	}
+	#pragma omp parallel for
+	for (long i = 0; i < (long)in_mesh->nverts; i++) {
+		vl_mesh_desc_vert(verts + i, in_mesh, (VL_Size)i);
+	}
+	vl_mesh_desc_bbox(&vmin, &vmax, in_mesh);
+	if (!vl_weld_vertices(remap, verts, in_mesh->nverts, &vmin, &vmax, in_weld_tol)) {
+		free(verts);
+		free(remap);
+		free(faces);
+		return false;
+	}
+	#pragma omp parallel for
+	for (long f = 0; f < (long)nfaces; f++) {
+		for (int k = 0; k < 3; k++) {
+			faces[f * 3 + k] = remap[vl_mesh_desc_index(in_mesh, (VL_Size)f, k)];
+		}
+	}
+	if (!vl_sort_faces(faces, &nfaces, verts, in_mesh->nverts, &vmin, &vmax)) {
+		free(verts);
+		free(remap);
+		free(faces);
+		return false;
+	}
+
+	// Number vertices by first use along sorted faces, unused ones are dropped
+	out_mesh->verts = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * in_mesh->nverts);
+	if (NULL == out_mesh->verts) {
+		free(verts);
+		free(remap);
+		free(faces);
+		return false;
+	}
+	for (VL_Size i = 0; i < in_mesh->nverts; i++) {
+		remap[i] = (VL_Size)-1;
+	}
+	for (VL_Size i = 0; i < nfaces * 3; i++) {
+		if (remap[faces[i]] == (VL_Size)-1) {
+			out_mesh->verts[nverts] = verts[faces[i]];
+			remap[faces[i]] = nverts++;
+		}
+		faces[i] = remap[faces[i]];
+	}
+	free(verts);
+	free(remap);
+	out_mesh->nverts = nverts;
+	out_mesh->faces = faces;
+	out_mesh->nfaces = nfaces;
+	return true;
+}
+
+
+_VL_EXTERN_ bool vl_mesh_prepare(
+	_VL_OUT_ VL_Mesh * const           out_mesh,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_weld_tol
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_mesh_prepare_desc(out_mesh, &mesh, in_weld_tol);
+}
+
+
+_VL_EXTERN_ void vl_mesh_free(VL_Mesh * const mesh) {
+	free(mesh->verts);
+	free(mesh->faces);
+	memset(mesh, 0, sizeof(VL_Mesh));
+}
+
+
+_VL_EXTERN_ bool vl_cached_point_cloud_from_mesh_desc(
+	_VL_OUT_ VL_CachedPointCloud * const out_point_cloud,
+	_VL_IN_  const char * const          in_dir,
+	_VL_IN_  const double                in_max_bytes,
+	_VL_IN_  const VL_MeshDesc * const   in_mesh,
+	_VL_IN_  const VL_Float              in_vsize
+	) {
+	VL_CacheFileHeader header;
+	uint64_t key, check;
+	char * path = NULL;
+
+	memset(out_point_cloud, 0, sizeof(VL_CachedPointCloud));
+	// Checked up front, a cache hit would otherwise skip validation of voxelization
+	if (!vl_mesh_desc_is_valid(in_mesh)) {
+		return false;
+	}
+	if (in_dir && vl_cache_key(&key, &check, in_mesh, in_vsize, VL_ECacheKindPointCloud)) {
+		path = vl_cache_path(in_dir, key, ".vlc");
+	}
+	if (path) {
+		vl_cache_header_init(&header, key, check, in_mesh, VL_ECacheKindPointCloud, 0, in_vsize);
+		if (vl_cache_map(out_point_cloud, path, &header)) {
+			free(path);
+			return true;
+		}
+	}
+	out_point_cloud->points = vl_point_cloud_from_mesh_desc(NULL, &out_point_cloud->npoints, in_mesh, in_vsize);
+	if (NULL == out_point_cloud->points) {
+		free(path);
+		return false;
+	}
+	if (path) {
+		header.npoints = out_point_cloud->npoints;
+		vl_cache_publish(in_dir, path, &header, out_point_cloud->points, in_max_bytes);
+		free(path);
+	}
+	return true;
+}
+
+
+_VL_EXTERN_ bool vl_cached_point_cloud_from_mesh(
+	_VL_OUT_ VL_CachedPointCloud * const out_point_cloud,
+	_VL_IN_  const char * const          in_dir,
+	_VL_IN_  const double                in_max_bytes,
+	_VL_IN_  const VL_Vector3F * const   in_verts,
+	_VL_IN_  const VL_Size               in_nverts,
+	_VL_IN_  const VL_Size * const       in_faces,
+	_VL_IN_  const VL_Size               in_nfaces,
+	_VL_IN_  const VL_Float              in_vsize
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_cached_point_cloud_from_mesh_desc(out_point_cloud, in_dir, in_max_bytes, &mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ void vl_cached_point_cloud_free(VL_CachedPointCloud * const point_cloud) {
+	if (point_cloud->map) {
+#ifdef _WIN32
+		UnmapViewOfFile(point_cloud->map);
+#else
+		munmap(point_cloud->map, point_cloud->map_bytes);
+#endif
+	} else {
+		free((void *)point_cloud->points);
+	}
+	memset(point_cloud, 0, sizeof(VL_CachedPointCloud));
+}
+
+
+_VL_EXTERN_ VL_Float vl_cached_volume_from_mesh_desc(
+	_VL_IN_  const char * const        in_dir,
+	_VL_IN_  const double              in_max_bytes,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_CacheFileHeader header, expected;
+	VL_MassProperties props;
+	uint64_t key, check;
+	char * path = NULL;
+
+	if (!vl_mesh_desc_is_valid(in_mesh)) {
+		return 0.0;
+	}
+	if (in_dir && vl_cache_key(&key, &check, in_mesh, in_vsize, VL_ECacheKindVolume)) {
+		path = vl_cache_path(in_dir, key, ".vlc");
+	}
+	if (path) {
+		vl_cache_header_init(&expected, key, check, in_mesh, VL_ECacheKindVolume, 0, in_vsize);
+		if (vl_cache_read_header(&header, path, &expected)) {
+			free(path);
+			// Same rounding as vl_mass_properties_from_masks, so a hit returns what the miss did
+			return (VL_Float)((double)header.npoints * in_vsize * in_vsize * in_vsize);
+		}
+	}
+	if (!vl_mass_properties_from_mesh_desc(&props, in_mesh, in_vsize)) {
+		free(path);
+		return 0.0;
+	}
+	if (path) {
+		expected.npoints = props.nvoxels;
+		vl_cache_publish(in_dir, path, &expected, NULL, in_max_bytes);
+		free(path);
+	}
+	return props.volume;
+}
+
+
+_VL_EXTERN_ VL_Float vl_cached_volume_from_mesh(
+	_VL_IN_  const char * const        in_dir,
+	_VL_IN_  const double              in_max_bytes,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	) {
+	VL_MeshDesc mesh;
+	vl_mesh_desc_native(&mesh, in_verts, in_nverts, in_faces, in_nfaces);
+	return vl_cached_volume_from_mesh_desc(in_dir, in_max_bytes, &mesh, in_vsize);
+}
+
+
+_VL_EXTERN_ bool vl_labels_from_grid(
+	_VL_OUT_ VL_Labels * const          out_labels,
+	_VL_IN_  const VL_VoxelGrid * const in_grid,
+	_VL_IN_  const VL_Connectivity      in_connectivity,
+	_VL_IN_  const VL_Size              in_keep_largest
+	) {
+	const VL_Size cx = in_grid->header.cx, cy = in_grid->header.cy, cz = in_grid->header.cz;
+	const VL_Size nslabs = (cz + VL_LABELS_SLAB - 1) / VL_LABELS_SLAB;
+	VL_Size * parent;
+
+	memset(out_labels, 0, sizeof(VL_Labels));
+	out_labels->header = in_grid->header;
+	out_labels->row_offsets = (VL_Size *)calloc(cy * cz + 1, sizeof(VL_Size));
+	if (NULL == out_labels->row_offsets) {
+		return false;
+	}
+
+	// Runs of solid voxels per row, counted first and extracted second
+	#pragma omp parallel for schedule(static)
+	for (long r = 0; r < (long)(cy * cz); r++) {
+		const uint64_t * row = in_grid->bits + (VL_Size)r * in_grid->nwords;
+		VL_Size n = 0;
+		for (VL_Size x = vl_grid_row_next(row, cx, 0, true); x < cx; n++) {
+			x = vl_grid_row_next(row, cx, vl_grid_row_next(row, cx, x, false), true);
+		}
+		out_labels->row_offsets[r + 1] = n;
+	}
+	for (VL_Size r = 0; r < cy * cz; r++) {
+		out_labels->row_offsets[r + 1] += out_labels->row_offsets[r];
+	}
+	out_labels->nruns = out_labels->row_offsets[cy * cz];
+	out_labels->run_x0 = (VL_Size *)malloc(sizeof(VL_Size) * (out_labels->nruns + 1));
+	out_labels->run_x1 = (VL_Size *)malloc(sizeof(VL_Size) * (out_labels->nruns + 1));
+	out_labels->run_labels = (VL_Size *)malloc(sizeof(VL_Size) * (out_labels->nruns + 1));
+	parent = (VL_Size *)malloc(sizeof(VL_Size) * (out_labels->nruns + 1));
+	if ((NULL == out_labels->run_x0) || (NULL == out_labels->run_x1) ||
+		(NULL == out_labels->run_labels) || (NULL == parent)) {
+		free(parent);
+		vl_labels_free(out_labels);
+		return false;
+	}
+	#pragma omp parallel for schedule(static)
+	for (long r = 0; r < (long)(cy * cz); r++) {
+		const uint64_t * row = in_grid->bits + (VL_Size)r * in_grid->nwords;
+		VL_Size i = out_labels->row_offsets[r];
+		for (VL_Size x = vl_grid_row_next(row, cx, 0, true); x < cx; i++) {
+			out_labels->run_x0[i] = x;
+			x = vl_grid_row_next(row, cx, x, false);
+			out_labels->run_x1[i] = x;
+			parent[i] = i;
+			x = vl_grid_row_next(row, cx, x, true);
+		}
 	}
 
-	// Trace Top
-	for (VL_Size y = 0; y < cy; y++) {
-		for (VL_Size x = 0; x < cx; x++) {
-			int hit;
-			vcenter.x = x * in_vsize + vmin.x;
-			vcenter.y = y * in_vsize + vmin.y;
-			vcenter.z = 0.0;
-			vl_proj_vert_top(&vcenter, &vcenter);
-			for (VL_Size f = 0; f < in_nfaces; f++) {
-				VL_Size idx = in_faces[f * 3 + 0];
-				VL_Size idy = in_faces[f * 3 + 1];
-				VL_Size idz = in_faces[f * 3 + 2];
-				hit = vl_is_voxel_tri_intersected_proj(
-						VL_EProjectNone,
-						verts_top + idx,
-						verts_top + idy,
-						verts_top + idz,
-						&vcenter,
-						in_vsize
-						);
-				if (hit) {
-					buff_top[y * cx + x] = hit;
-					break;
+	// Union find within slabs of z in parallel, every link stays inside its slab
+	#pragma omp parallel for schedule(dynamic)
+	for (long s = 0; s < (long)nslabs; s++) {
+		const VL_Size z0 = (VL_Size)s * VL_LABELS_SLAB, z1 = VL_MIN(z0 + VL_LABELS_SLAB, cz);
+		for (VL_Size z = z0; z < z1; z++) {
+			for (VL_Size y = 0; y < cy; y++) {
+				if (z == z0) {
+					vl_labels_merge_rows(parent, out_labels, y, z, -1, 0, in_connectivity == VL_EConnect6 ? 0 : 1);
+				} else {
+					vl_labels_merge_row(parent, out_labels, y, z, in_connectivity, true);
 				}
 			}
 		}
 	}
-
-	// Accumulate hit voxel count for point cloud memmory allocation
-	for (VL_Size x = 0; x < cx; x++) {
+	// Then across slab boundaries, first slice of every slab against last slice of previous one
+	for (VL_Size s = 1; s < nslabs; s++) {
 		for (VL_Size y = 0; y < cy; y++) {
-			for (VL_Size z = 0; z < cz; z++) {
-				id_front = z * cx + x;
-				id_left  = z * cy + y;
-				id_top   = y * cx + x;
-				if (buff_front[id_front] && buff_left[id_left] && buff_top[id_top]) {
-					*out_npoints += 1;
-				}
+			vl_labels_merge_row(parent, out_labels, y, s * VL_LABELS_SLAB, in_connectivity, false);
+		}
+	}
+
+	// Roots precede their runs, so flattening in run order sees parents already flattened
+	for (VL_Size i = 0; i < out_labels->nruns; i++) {
+		parent[i] = parent[parent[i]];
+		if (parent[i] == i) {
+			out_labels->ncomponents++;
+		}
+	}
+	out_labels->components = (VL_Component *)calloc(out_labels->ncomponents + 1, sizeof(VL_Component));
+	if (NULL == out_labels->components) {
+		free(parent);
+		vl_labels_free(out_labels);
+		return false;
+	}
+	for (VL_Size r = 0, label = 0; r < cy * cz; r++) {
+		const VL_Size y = r % cy, z = r / cy;
+		for (VL_Size i = out_labels->row_offsets[r]; i < out_labels->row_offsets[r + 1]; i++) {
+			VL_Component * c;
+			out_labels->run_labels[i] = (parent[i] == i) ? ++label : out_labels->run_labels[parent[i]];
+			c = out_labels->components + out_labels->run_labels[i] - 1;
+			if (c->count == 0) {
+				c->minx = out_labels->run_x0[i]; c->maxx = out_labels->run_x1[i] - 1;
+				c->miny = c->maxy = y;
+				c->minz = c->maxz = z;
 			}
+			c->count += out_labels->run_x1[i] - out_labels->run_x0[i];
+			c->minx = VL_MIN(c->minx, out_labels->run_x0[i]);
+			c->maxx = VL_MAX(c->maxx, out_labels->run_x1[i] - 1);
+			c->miny = VL_MIN(c->miny, y);
+			c->maxy = VL_MAX(c->maxy, y);
+			c->maxz = z;
 		}
 	}
-	// Allocate memmory for point cloud
-	temp_point_cloud = (VL_Vector3F *)malloc(sizeof(VL_Vector3F) * (*out_npoints));
-	if (NULL == temp_point_cloud) {
-		if (NULL != buff_front) free(buff_front);
-		if (NULL != buff_left) free(buff_left);
-		if (NULL != buff_top) free(buff_top);
-		if (NULL != verts_front) free(verts_front);
-		if (NULL != verts_left) free(verts_left);
-		if (NULL != verts_top) free(verts_top);
-		if (NULL != *out_point_cloud) free(*out_point_cloud);
-		*out_npoints = 0;
-		if (out_point_cloud) { *out_point_cloud = NULL; }
-		return NULL;
+	free(parent);
+	if ((in_keep_largest > 0) && !vl_labels_keep_largest(out_labels, in_keep_largest)) {
+		vl_labels_free(out_labels);
+		return false;
 	}
-	for (VL_Size x = 0; x < cx; x++) {
-		for (VL_Size y = 0; y < cy; y++) {
-			for (VL_Size z = 0; z < cz; z++) {
-				id_front = z * cx + x;
-				id_left  = z * cy + y;
-				id_top   = y * cx + x;
-				if (buff_front[id_front] && buff_left[id_left] && buff_top[id_top]) {
-					(temp_point_cloud + counter)->x = x * in_vsize + halfsize + vmin.x;
-					(temp_point_cloud + counter)->y = y * in_vsize + halfsize + vmin.y;
-					(temp_point_cloud + counter)->z = z * in_vsize + halfsize + vmin.z;
-					counter++;
-				}
+	return true;
+}
+
+
+_VL_EXTERN_ void vl_labels_free(VL_Labels * const labels) {
+	free(labels->row_offsets);
+	free(labels->run_x0);
+	free(labels->run_x1);
+	free(labels->run_labels);
+	free(labels->components);
+	memset(labels, 0, sizeof(VL_Labels));
+}
+
+
+_VL_EXTERN_ VL_Size vl_labels_at(const VL_Labels * const labels, const VL_Size in_x, const VL_Size in_y, const VL_Size in_z) {
+	VL_Size lo, hi;
+	if ((in_x >= labels->header.cx) || (in_y >= labels->header.cy) || (in_z >= labels->header.cz)) {
+		return 0;
+	}
+	// Last run starting at or before x
+	lo = labels->row_offsets[in_z * labels->header.cy + in_y];
+	hi = labels->row_offsets[in_z * labels->header.cy + in_y + 1];
+	while (lo < hi) {
+		VL_Size mid = lo + (hi - lo) / 2;
+		if (labels->run_x0[mid] <= in_x) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if ((lo == labels->row_offsets[in_z * labels->header.cy + in_y]) || (in_x >= labels->run_x1[lo - 1])) {
+		return 0;
+	}
+	return labels->run_labels[lo - 1];
+}
+
+
+_VL_EXTERN_ void vl_labels_fill(const VL_Labels * const labels, VL_Size * const out_dense) {
+	const VL_Size cx = labels->header.cx, cy = labels->header.cy, cz = labels->header.cz;
+	#pragma omp parallel for schedule(static)
+	for (long r = 0; r < (long)(cy * cz); r++) {
+		VL_Size * dense = out_dense + (VL_Size)r * cx;
+		memset(dense, 0, sizeof(VL_Size) * cx);
+		for (VL_Size i = labels->row_offsets[r]; i < labels->row_offsets[r + 1]; i++) {
+			for (VL_Size x = labels->run_x0[i]; x < labels->run_x1[i]; x++) {
+				dense[x] = labels->run_labels[i];
 			}
 		}
 	}
+}
 
-	free(buff_front);
-	free(buff_left);
-	free(buff_top);
-	free(verts_front);
-	free(verts_left);
-	free(verts_top);
 
-	if (out_point_cloud) { *out_point_cloud = temp_point_cloud; }
-	return temp_point_cloud;
+_VL_EXTERN_ bool vl_grid_from_labels(
+	_VL_OUT_ VL_VoxelGrid * const    out_grid,
+	_VL_IN_  const VL_Labels * const in_labels,
+	_VL_IN_  const VL_Size           in_label
+	) {
+	const VL_Size cy = in_labels->header.cy, cz = in_labels->header.cz;
+	if (!vl_grid_alloc(out_grid, &in_labels->header)) {
+		return false;
+	}
+	#pragma omp parallel for schedule(static)
+	for (long r = 0; r < (long)(cy * cz); r++) {
+		uint64_t * row = out_grid->bits + (VL_Size)r * out_grid->nwords;
+		for (VL_Size i = in_labels->row_offsets[r]; i < in_labels->row_offsets[r + 1]; i++) {
+			if ((in_label == 0) ? (in_labels->run_labels[i] != 0) : (in_labels->run_labels[i] == in_label)) {
+				vl_grid_row_fill(row, in_labels->run_x0[i], in_labels->run_x1[i]);
+			}
+		}
+	}
+	return true;
 }
 
 
+_VL_EXTERN_ bool vl_grid_morphology(
+	_VL_OUT_ VL_VoxelGrid * const       out_grid,
+	_VL_IN_  const VL_VoxelGrid * const in_src,
+	_VL_IN_  const VL_MorphOp           in_op,
+	_VL_IN_  const VL_MorphElement      in_element,
+	_VL_IN_  const VL_Size              in_radius
+	) {
+	const VL_Size maxdim = VL_MAX(VL_MAX(in_src->header.cx, in_src->header.cy), in_src->header.cz);
+	VL_Size radius = in_radius;
+	VL_VoxelGrid a, b;
+	bool ok = false;
+
+	memset(out_grid, 0, sizeof(VL_VoxelGrid));
+	// Frame grown by 2 * radius must still be indexed by VL_Size
+	if (!((double)maxdim + 2.0 * (double)in_radius < (double)(VL_Size)-1)) {
+		return false;
+	}
+	// Erosion by an element reaching past every frame border leaves nothing, whatever the radius
+	if ((in_op == VL_EMorphErode) || (in_op == VL_EMorphOpen)) {
+		radius = VL_MIN(radius, maxdim);
+	}
+	switch (in_op) {
+		case VL_EMorphDilate:
+			// Grow frame first so nothing is clipped
+			if (vl_grid_reframe(&a, in_src, (long long)radius)) {
+				ok = vl_grid_morph_frame(out_grid, &a, in_element, radius, VL_EBoolUnion);
+				vl_grid_free(&a);
+			}
+			break;
+		case VL_EMorphErode:
+			ok = vl_grid_morph_frame(out_grid, in_src, in_element, radius, VL_EBoolIntersection);
+			break;
+		case VL_EMorphClose:
+			// Erosion of voxels in original frame only reads grown frame, so cropping back is exact
+			if (vl_grid_reframe(&a, in_src, (long long)radius)) {
+				if (vl_grid_morph_frame(&b, &a, in_element, radius, VL_EBoolUnion)) {
+					vl_grid_free(&a);
+					if (vl_grid_morph_frame(&a, &b, in_element, radius, VL_EBoolIntersection)) {
+						ok = vl_grid_reframe(out_grid, &a, -(long long)radius);
+						vl_grid_free(&a);
+					}
+					vl_grid_free(&b);
+				} else {
+					vl_grid_free(&a);
+				}
+			}
+			break;
+		case VL_EMorphOpen:
+			// Opening stays inside input, so dilating back needs no grown frame
+			if (vl_grid_morph_frame(&a, in_src, in_element, radius, VL_EBoolIntersection)) {
+				ok = vl_grid_morph_frame(out_grid, &a, in_element, radius, VL_EBoolUnion);
+				vl_grid_free(&a);
+			}
+			break;
+	}
+	return ok;
+}
@@ -39,6 +39,236 @@ typedef unsigned int VL_Size;
 typedef struct { VL_Float x, y, z; } VL_Vector3F;
 
 
+/*
+ * Input mesh read in place from typed, strided buffers, eg. interleaved renderer vertex buffers
+ * Vertex i is three components starting at verts + i * vert_stride, stride 0 means tightly packed
+ * Face f is indices 3 * f, 3 * f + 1 and 3 * f + 2 of a tightly packed index buffer
+ */
+typedef enum {
+	VL_EComponentFloat32,
+	VL_EComponentFloat64,
+} VL_ComponentType;
+
+
+typedef enum {
+	VL_EIndexU16,
+	VL_EIndexU32,
+	VL_EIndexU64,
+} VL_IndexType;
+
+
+typedef struct {
+	const void *     verts;
+	VL_ComponentType vert_type;
+	size_t           vert_stride;
+	VL_Size          nverts;
+	const void *     faces;
+	VL_IndexType     face_type;
+	VL_Size          nfaces;
+} VL_MeshDesc;
+
+
+/*
+ * Mesh owned by library, eg. output of vl_mesh_prepare
+ * Can be passed to every vl_*_from_mesh function as is
+ */
+typedef struct {
+	VL_Vector3F * verts;
+	VL_Size       nverts;
+	VL_Size *     faces;
+	VL_Size       nfaces;
+} VL_Mesh;
+
+
+/*
+ * Grid frame of integer voxel output
+ * Voxel (x, y, z) spans origin + (x, y, z) * vsize to origin + (x + 1, y + 1, z + 1) * vsize
+ */
+typedef struct {
+	VL_Vector3F origin;
+	VL_Float    vsize;
+	VL_Size     cx, cy, cz;
+} VL_VoxelHeader;
+
+
+/*
+ * Dense bit packed voxel grid
+ * Row (y, z) is nwords 64 bit words at bits + (z * cy + y) * nwords, voxel x is bit x % 64 of word x / 64
+ * Bits past cx in the last word of a row are always clear
+ */
+typedef struct {
+	VL_VoxelHeader header;
+	VL_Size        nwords;
+	uint64_t *     bits;
+} VL_VoxelGrid;
+
+
+/*
+ * Boolean operations between voxel grids
+ */
+typedef enum {
+	VL_EBoolUnion,
+	VL_EBoolIntersection,
+	VL_EBoolDifference,
+	VL_EBoolXor,
+} VL_BoolOp;
+
+
+/*
+ * Morphological operations on voxel grids, closing is dilation then erosion, opening the reverse
+ */
+typedef enum {
+	VL_EMorphDilate,
+	VL_EMorphErode,
+	VL_EMorphClose,
+	VL_EMorphOpen,
+} VL_MorphOp;
+
+
+/*
+ * Structuring elements of radius r, voxel offsets d with max |d| <= r, one nonzero |d| <= r or |d|^2 <= r^2
+ */
+typedef enum {
+	VL_EElementBox,
+	VL_EElementCross,
+	VL_EElementSphere,
+} VL_MorphElement;
+
+
+/*
+ * Voxels sharing a face are always connected, 18 adds voxels sharing an edge and 26 voxels sharing a corner
+ */
+typedef enum {
+	VL_EConnect6  = 6,
+	VL_EConnect18 = 18,
+	VL_EConnect26 = 26,
+} VL_Connectivity;
+
+
+/*
+ * Voxel count and inclusive voxel bbox of a connected component
+ */
+typedef struct {
+	VL_Size count;
+	VL_Size minx, miny, minz;
+	VL_Size maxx, maxy, maxz;
+} VL_Component;
+
+
+/*
+ * Connected components of a voxel grid, stored per run of consecutive solid voxels along x
+ * Row (y, z) holds runs row_offsets[z * cy + y] to row_offsets[z * cy + y + 1], run i spans [run_x0[i], run_x1[i])
+ * Run labels are 1 to ncomponents with component of label l at components[l - 1], 0 marks dropped runs
+ */
+typedef struct {
+	VL_VoxelHeader header;
+	VL_Size *      row_offsets;
+	VL_Size *      run_x0;
+	VL_Size *      run_x1;
+	VL_Size *      run_labels;
+	VL_Size        nruns;
+	VL_Component * components;
+	VL_Size        ncomponents;
+} VL_Labels;
+
+
+/*
+ * Rigid body properties of solid voxels at unit density, so mass equals volume
+ * Inertia tensor is taken about centroid and includes each voxel's own cube inertia
+ */
+typedef struct {
+	VL_Size     nvoxels;
+	VL_Float    volume;
+	VL_Vector3F centroid;
+	VL_Float    inertia[3][3];
+} VL_MassProperties;
+
+
+/*
+ * Point cloud served by cache, either mapped read only from cache file or on heap
+ * Should be freed by vl_cached_point_cloud_free
+ */
+typedef struct {
+	const VL_Vector3F * points;
+	VL_Size             npoints;
+	// Mapped cache file, NULL when points are on heap
+	void *              map;
+	size_t              map_bytes;
+} VL_CachedPointCloud;
+
+
+/*
+ * Estimated cost of voxelizing a mesh with vl_point_cloud_from_mesh
+ * Byte counts and work are kept in double so that they can not overflow themselves
+ */
+typedef struct {
+	VL_Float vsize;
+	VL_Size  cx, cy, cz;
+	// Upper bound of solid voxel count, all voxels in bbox
+	double   max_points;
+	// Estimated solid voxel count from enclosed volume and projected surface area
+	double   est_points;
+	// Estimated and worst case peak heap usage in bytes
+	double   peak_bytes;
+	double   max_peak_bytes;
+	// Approximate count of tile binnings, pixel-triangle tests along outlines and voxel visits
+	double   work;
+	// Grid indices or byte counts would overflow VL_Size or size_t, nothing else is filled
+	bool     overflow;
+} VL_Plan;
+
+
+/*
+ * Sparse voxel octree node
+ * Child i covers half of parent with x offset (i & 1), y offset (i & 2) and z offset (i & 4)
+ * A child is empty, full or mixed; only mixed children have nodes, stored contiguously in bit order from child
+ */
+typedef struct {
+	uint32_t child;
+	uint8_t  mixed;
+	uint8_t  full;
+	uint16_t reserved;
+} VL_SvoNode;
+
+
+/*
+ * Sparse voxel octree, root spans 2^depth voxels per axis from header origin
+ * Nodes are one linear array addressed by index, it can be written and read back as is
+ * root is index of root node, or VL_SVO_EMPTY / VL_SVO_FULL when the whole grid is uniform
+ */
+typedef struct {
+	VL_VoxelHeader header;
+	uint32_t       depth;
+	uint32_t       root;
+	uint32_t       nnodes;
+	VL_SvoNode *   nodes;
+} VL_Svo;
+
+
+#define VL_SVO_EMPTY ((uint32_t)0xffffffff)
+#define VL_SVO_FULL  ((uint32_t)0xfffffffe)
+
+
+/*
+ * File formats of vl_write_mesh_from_point_cloud
+ */
+typedef enum {
+	VL_EFormatObj,  // ASCII OBJ
+	VL_EFormatPly,  // Binary little endian PLY, float vertices and uint indices
+	VL_EFormatStl,  // Binary STL
+} VL_MeshFormat;
+
+
+// Max definition per axis of morton keys, 21 bits of each axis are packed into 64 bits
+#define VL_MORTON_MAX_RES ((VL_Size)1 << 21)
+
+
+/*
+ * Version of voxelization output, part of cache keys, bump whenever output for the same input changes
+ */
+#define VL_CACHE_VERSION 2
+
+
 /*
  * Necessary vector3 mathematics
  * Be easy when using add, sub, mul and div, I've added temp variable to avoid cyclic operation
@@ -55,6 +285,7 @@ _VL_STATIC_ void vl_vec3_cross(VL_Vector3F * out, const VL_Vector3F * const a, c
 
 /*
  * Get point cloud difinition from mesh in pre calculation
+ * Definitions are 0 if grid is too large to index, see vl_plan_from_mesh
  *
  * @outcx        Output definition in x axis
  * @outcy        Output definition in y axis
@@ -80,6 +311,7 @@ vl_point_cloud_res_from_mesh(
 
 /*
  * Get point cloud difinition from bbox in pre calculation
+ * Definitions are 0 if grid is too large to index, see vl_plan_from_mesh
  *
  * @outcx        Output definition in x axis
  * @outcy        Output definition in y axis
@@ -102,7 +334,7 @@ vl_point_cloud_res_from_bbox(
 /*
  * Generate point cloud fron mesh, result point cloud should be freed mannually
  *
- * Return:       Output point cloud pointer
+ * Return:       Output point cloud pointer, NULL if grid is too large to index, see vl_plan_from_mesh
  * @point_cloud: Output point cloud pointer, result will be returned although NULL is passed
  * @npoints:     Ouput point cloud count
  * @verts:       Input vertices
@@ -123,6 +355,81 @@ vl_point_cloud_from_mesh(
 	);
 
 
+/*
+ * Generate morton ordered voxel keys fron mesh, result keys should be freed mannually
+ * Keys are sorted ascending so voxels are listed in Z-order, which keeps neighbours close in memory
+ *
+ * Return:       Output keys pointer, NULL if any definition exceeds VL_MORTON_MAX_RES
+ * @keys:        Output keys pointer, result will be returned although NULL is passed
+ * @nkeys:       Output key count
+ * @header:      Output grid frame of keys
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @vsize:       Input voxel size
+ */
+_VL_EXTERN_ uint64_t *
+vl_morton_from_mesh(
+	_VL_OPT_OUT_ uint64_t ** const         out_keys,
+	_VL_OUT_     VL_Size * const           out_nkeys,
+	_VL_OUT_     VL_VoxelHeader * const    out_header,
+	_VL_IN_      const VL_Vector3F * const in_verts,
+	_VL_IN_      const VL_Size             in_nverts,
+	_VL_IN_      const VL_Size * const     in_faces,
+	_VL_IN_      const VL_Size             in_nfaces,
+	_VL_IN_      const VL_Float            in_vsize
+	);
+
+
+/*
+ * Interleave voxel coordinates into a morton key, x takes the lowest bit
+ *
+ * Return:       Output morton key
+ * @x:           Input voxel x, only low 21 bits are kept
+ * @y:           Input voxel y, only low 21 bits are kept
+ * @z:           Input voxel z, only low 21 bits are kept
+ */
+_VL_EXTERN_ uint64_t
+vl_morton_encode(
+	_VL_IN_ const VL_Size in_x,
+	_VL_IN_ const VL_Size in_y,
+	_VL_IN_ const VL_Size in_z
+	);
+
+
+/*
+ * Split a morton key back into voxel coordinates
+ *
+ * @x:           Output voxel x
+ * @y:           Output voxel y
+ * @z:           Output voxel z
+ * @key:         Input morton key
+ */
+_VL_EXTERN_ void
+vl_morton_decode(
+	_VL_OUT_ VL_Size * const out_x,
+	_VL_OUT_ VL_Size * const out_y,
+	_VL_OUT_ VL_Size * const out_z,
+	_VL_IN_  const uint64_t  in_key
+	);
+
+
+/*
+ * Get voxel center of a morton key, same as points of vl_point_cloud_from_mesh
+ *
+ * @point:       Output voxel center
+ * @header:      Input grid frame of keys
+ * @key:         Input morton key
+ */
+_VL_EXTERN_ void
+vl_point_from_morton(
+	_VL_OUT_ VL_Vector3F * const          out_point,
+	_VL_IN_  const VL_VoxelHeader * const in_header,
+	_VL_IN_  const uint64_t               in_key
+	);
+
+
 /*
  * Generate mesh fron point cloud, verts and faces pointer should be freed manually after use
  *
@@ -146,9 +453,31 @@ vl_mesh_from_point_cloud(
 	);
 
 
+/*
+ * Write the mesh of vl_mesh_from_point_cloud straight into a file descriptor
+ * Geometry is generated voxel by voxel into a fixed size buffer, so memory does not grow with point count
+ * Triangles are wound counter clockwise seen from outside of each voxel
+ *
+ * Return:       false if writing failed or counts do not fit in the format
+ * @fd:          Input file descriptor opened for writing
+ * @format:      Input file format
+ * @point_cloud: Input point cloud
+ * @npoints:     Input point cloud count
+ * @vsize:       Input voxel size
+ */
+_VL_EXTERN_ bool
+vl_write_mesh_from_point_cloud(
+	_VL_IN_ const int                 in_fd,
+	_VL_IN_ const VL_MeshFormat       in_format,
+	_VL_IN_ const VL_Vector3F * const in_point_cloud,
+	_VL_IN_ const VL_Size             in_npoints,
+	_VL_IN_ const VL_Float            in_vsize
+	);
+
+
 /*
  * Get mesh volume
- * This implementation uses vl_point_cloud_from_mesh to generate point cloud and cound point for volume
+ * This implementation counts solid voxels of vl_point_cloud_from_mesh without generating point cloud
  *
  * Return:       Mesh volume
  * @verts:       Input vertices
@@ -167,4 +496,451 @@ vl_volume_from_mesh(
 	);
 
 
+/*
+ * Estimate memory and work of voxelizing mesh before doing it
+ *
+ * Return:       false if mesh is empty, grid would overflow or memory allocation failed
+ * @plan:        Output plan
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @vsize:       Input voxel size
+ */
+_VL_EXTERN_ bool
+vl_plan_from_mesh(
+	_VL_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+/*
+ * Find the finest voxel size whose estimated peak memory and work fit in budget
+ *
+ * Return:       Voxel size, 0 if even a single voxel does not fit or memory allocation failed
+ * @plan:        Output plan of returned voxel size
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @max_bytes:   Input memory budget in bytes, compared with peak_bytes of plan
+ * @max_work:    Input work budget in units of VL_Plan.work, <= 0 means unlimited
+ */
+_VL_EXTERN_ VL_Float
+vl_plan_vsize_from_budget(
+	_VL_OPT_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_      const VL_Vector3F * const in_verts,
+	_VL_IN_      const VL_Size             in_nverts,
+	_VL_IN_      const VL_Size * const     in_faces,
+	_VL_IN_      const VL_Size             in_nfaces,
+	_VL_IN_      const double              in_max_bytes,
+	_VL_IN_      const double              in_max_work
+	);
+
+
+/*
+ * Build sparse voxel octree from mesh, uniform regions are collapsed into single children
+ * Memory scales with surface of solid rather than its volume
+ *
+ * Return:       false if mesh is empty or memory allocation failed
+ * @svo:         Output octree, should be freed by vl_svo_free
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @vsize:       Input voxel size
+ */
+_VL_EXTERN_ bool
+vl_svo_from_mesh(
+	_VL_OUT_ VL_Svo * const            out_svo,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ void vl_svo_free(VL_Svo * const svo);
+
+
+/*
+ * Whether voxel (x, y, z) of octree is solid
+ */
+_VL_EXTERN_ bool vl_svo_lookup(const VL_Svo * const svo, const VL_Size in_x, const VL_Size in_y, const VL_Size in_z);
+
+
+/*
+ * Cast ray against octree, visiting children front to back and skipping empty ones
+ *
+ * Return:       Whether ray hits any solid voxel
+ * @t:           Output ray parameter of first hit, hit point is origin + t * dir
+ * @svo:         Input octree
+ * @origin:      Input ray origin
+ * @dir:         Input ray direction
+ */
+_VL_EXTERN_ bool
+vl_svo_raycast(
+	_VL_OUT_ VL_Float * const          out_t,
+	_VL_IN_  const VL_Svo * const      svo,
+	_VL_IN_  const VL_Vector3F * const in_origin,
+	_VL_IN_  const VL_Vector3F * const in_dir
+	);
+
+
+/*
+ * Same as functions above without _desc suffix, but mesh is read in place through a descriptor
+ * so callers holding float32 interleaved vertices or 16/32 bit indices do not need to convert them first
+ * Every _desc function fails, as NULL, 0 or false, when any index is not below nverts
+ */
+_VL_EXTERN_ VL_Vector3F *
+vl_point_cloud_from_mesh_desc(
+	_VL_OPT_OUT_ VL_Vector3F ** const      out_point_cloud,
+	_VL_OUT_     VL_Size * const           out_npoints,
+	_VL_IN_      const VL_MeshDesc * const in_mesh,
+	_VL_IN_      const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ VL_Float
+vl_volume_from_mesh_desc(
+	_VL_IN_ const VL_MeshDesc * const in_mesh,
+	_VL_IN_ const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ uint64_t *
+vl_morton_from_mesh_desc(
+	_VL_OPT_OUT_ uint64_t ** const         out_keys,
+	_VL_OUT_     VL_Size * const           out_nkeys,
+	_VL_OUT_     VL_VoxelHeader * const    out_header,
+	_VL_IN_      const VL_MeshDesc * const in_mesh,
+	_VL_IN_      const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ bool
+vl_plan_from_mesh_desc(
+	_VL_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ VL_Float
+vl_plan_vsize_from_budget_desc(
+	_VL_OPT_OUT_ VL_Plan * const           out_plan,
+	_VL_IN_      const VL_MeshDesc * const in_mesh,
+	_VL_IN_      const double              in_max_bytes,
+	_VL_IN_      const double              in_max_work
+	);
+
+
+_VL_EXTERN_ bool
+vl_svo_from_mesh_desc(
+	_VL_OUT_ VL_Svo * const            out_svo,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+/*
+ * Voxelize mesh into a bit packed grid, 1 bit per voxel of bbox
+ *
+ * Return:       false if mesh is empty, grid would overflow or memory allocation failed
+ * @grid:        Output grid, should be freed by vl_grid_free
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @vsize:       Input voxel size
+ */
+_VL_EXTERN_ bool
+vl_grid_from_mesh(
+	_VL_OUT_ VL_VoxelGrid * const      out_grid,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ bool
+vl_grid_from_mesh_desc(
+	_VL_OUT_ VL_VoxelGrid * const      out_grid,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ void vl_grid_free(VL_VoxelGrid * const grid);
+_VL_EXTERN_ bool vl_grid_get(const VL_VoxelGrid * const grid, const VL_Size in_x, const VL_Size in_y, const VL_Size in_z);
+_VL_EXTERN_ VL_Size vl_grid_count(const VL_VoxelGrid * const grid);
+
+
+/*
+ * Voxel centers of grid, same layout as vl_point_cloud_from_mesh, result point cloud should be freed mannually
+ */
+_VL_EXTERN_ VL_Vector3F *
+vl_point_cloud_from_grid(
+	_VL_OPT_OUT_ VL_Vector3F ** const       out_point_cloud,
+	_VL_OUT_     VL_Size * const            out_npoints,
+	_VL_IN_      const VL_VoxelGrid * const in_grid
+	);
+
+
+/*
+ * Boolean operation of two grids with the same voxel size, computed row by row on 64 bit words
+ * Origin of b is snapped to the nearest voxel of a, result covers both grids for union and xor,
+ * their overlap for intersection and a for difference
+ *
+ * Return:       false if voxel sizes differ or memory allocation failed
+ * @grid:        Output grid, should be freed by vl_grid_free
+ * @a:           Input left operand
+ * @b:           Input right operand
+ * @op:          Input operation, difference is a minus b
+ */
+_VL_EXTERN_ bool
+vl_grid_boolean(
+	_VL_OUT_ VL_VoxelGrid * const       out_grid,
+	_VL_IN_  const VL_VoxelGrid * const in_a,
+	_VL_IN_  const VL_VoxelGrid * const in_b,
+	_VL_IN_  const VL_BoolOp            in_op
+	);
+
+
+/*
+ * Solid voxel count of vl_grid_boolean result without allocating it, eg. interference volume of two parts
+ *
+ * Return:       false if voxel sizes differ or memory allocation failed
+ * @count:       Output solid voxel count, 0 on failure
+ * @a:           Input left operand
+ * @b:           Input right operand
+ * @op:          Input operation, difference is a minus b
+ */
+_VL_EXTERN_ bool
+vl_grid_boolean_count(
+	_VL_OUT_ VL_Size * const            out_count,
+	_VL_IN_  const VL_VoxelGrid * const in_a,
+	_VL_IN_  const VL_VoxelGrid * const in_b,
+	_VL_IN_  const VL_BoolOp            in_op
+	);
+
+
+/*
+ * Get volume, centroid and inertia tensor of voxelized mesh in one pass over projection masks
+ * Voxels are never materialised, memory is that of the masks
+ *
+ * Return:       false if mesh is empty, grid would overflow or memory allocation failed
+ * @props:       Output mass properties, multiply volume and inertia by density for real mass
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @vsize:       Input voxel size
+ */
+_VL_EXTERN_ bool
+vl_mass_properties_from_mesh(
+	_VL_OUT_ VL_MassProperties * const out_props,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ bool
+vl_mass_properties_from_mesh_desc(
+	_VL_OUT_ VL_MassProperties * const out_props,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+/*
+ * Preprocess mesh once for faster voxelization in every later call on it
+ * Vertices closer than weld_tol are welded, degenerated and duplicated faces are removed,
+ * faces are sorted along Morton curve of their centroids and vertices are numbered by first use,
+ * so trace loops read neighbouring triangles and vertices from neighbouring memory
+ *
+ * Return:       false if mesh is empty or memory allocation failed
+ * @mesh:        Output mesh, should be freed by vl_mesh_free
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @weld_tol:    Input weld distance, 0 welds only vertices at identical positions
+ */
+_VL_EXTERN_ bool
+vl_mesh_prepare(
+	_VL_OUT_ VL_Mesh * const           out_mesh,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_weld_tol
+	);
+
+
+_VL_EXTERN_ bool
+vl_mesh_prepare_desc(
+	_VL_OUT_ VL_Mesh * const           out_mesh,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_weld_tol
+	);
+
+
+_VL_EXTERN_ void vl_mesh_free(VL_Mesh * const mesh);
+
+
+/*
+ * vl_point_cloud_from_mesh behind a persistent cache directory shared across processes
+ * Entries are keyed by a 128 bit hash of vertices, faces, voxel size, VL_CACHE_VERSION and type sizes,
+ * a hit also needs equal vertex and face counts, it maps the entry file read only instead of voxelizing,
+ * a miss voxelizes and publishes the entry atomically, then evicts least recently used entries above
+ * max_bytes along with temporary files left over by writers which died
+ * Cache directory must exist, cache failures fall back to plain voxelization silently
+ *
+ * Return:       false if voxelization failed
+ * @point_cloud: Output point cloud, should be freed by vl_cached_point_cloud_free
+ * @dir:         Input cache directory, NULL disables caching
+ * @max_bytes:   Input size bound of cache directory, <= 0 means unlimited
+ * @verts:       Input vertices
+ * @nverts:      Input vertex count
+ * @faces:       Input faces
+ * @nfaces:      Input face count
+ * @vsize:       Input voxel size
+ */
+_VL_EXTERN_ bool
+vl_cached_point_cloud_from_mesh(
+	_VL_OUT_ VL_CachedPointCloud * const out_point_cloud,
+	_VL_IN_  const char * const          in_dir,
+	_VL_IN_  const double                in_max_bytes,
+	_VL_IN_  const VL_Vector3F * const   in_verts,
+	_VL_IN_  const VL_Size               in_nverts,
+	_VL_IN_  const VL_Size * const       in_faces,
+	_VL_IN_  const VL_Size               in_nfaces,
+	_VL_IN_  const VL_Float              in_vsize
+	);
+
+
+_VL_EXTERN_ bool
+vl_cached_point_cloud_from_mesh_desc(
+	_VL_OUT_ VL_CachedPointCloud * const out_point_cloud,
+	_VL_IN_  const char * const          in_dir,
+	_VL_IN_  const double                in_max_bytes,
+	_VL_IN_  const VL_MeshDesc * const   in_mesh,
+	_VL_IN_  const VL_Float              in_vsize
+	);
+
+
+_VL_EXTERN_ void vl_cached_point_cloud_free(VL_CachedPointCloud * const point_cloud);
+
+
+/*
+ * vl_volume_from_mesh behind the same cache as vl_cached_point_cloud_from_mesh,
+ * entries hold voxel count only
+ */
+_VL_EXTERN_ VL_Float
+vl_cached_volume_from_mesh(
+	_VL_IN_  const char * const        in_dir,
+	_VL_IN_  const double              in_max_bytes,
+	_VL_IN_  const VL_Vector3F * const in_verts,
+	_VL_IN_  const VL_Size             in_nverts,
+	_VL_IN_  const VL_Size * const     in_faces,
+	_VL_IN_  const VL_Size             in_nfaces,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+_VL_EXTERN_ VL_Float
+vl_cached_volume_from_mesh_desc(
+	_VL_IN_  const char * const        in_dir,
+	_VL_IN_  const double              in_max_bytes,
+	_VL_IN_  const VL_MeshDesc * const in_mesh,
+	_VL_IN_  const VL_Float            in_vsize
+	);
+
+
+/*
+ * Label connected components of grid
+ * Runs are unioned with touching runs of neighbouring rows, in parallel within slabs of z and
+ * then across slab boundaries, labels follow scan order of each component's first voxel
+ *
+ * Return:       false if memory allocation failed
+ * @labels:      Output labels, should be freed by vl_labels_free
+ * @grid:        Input grid
+ * @connectivity Input voxel connectivity
+ * @keep_largest Input count of largest components to keep, relabeled by decreasing size, 0 keeps all
+ */
+_VL_EXTERN_ bool
+vl_labels_from_grid(
+	_VL_OUT_ VL_Labels * const          out_labels,
+	_VL_IN_  const VL_VoxelGrid * const in_grid,
+	_VL_IN_  const VL_Connectivity      in_connectivity,
+	_VL_IN_  const VL_Size              in_keep_largest
+	);
+
+
+_VL_EXTERN_ void vl_labels_free(VL_Labels * const labels);
+
+
+/*
+ * Label of voxel (x, y, z), 0 for empty or dropped voxels
+ */
+_VL_EXTERN_ VL_Size vl_labels_at(const VL_Labels * const labels, const VL_Size in_x, const VL_Size in_y, const VL_Size in_z);
+
+
+/*
+ * Expand labels into dense cx * cy * cz labels, voxel (x, y, z) at (z * cy + y) * cx + x
+ */
+_VL_EXTERN_ void vl_labels_fill(const VL_Labels * const labels, VL_Size * const out_dense);
+
+
+/*
+ * Grid of voxels of one component
+ *
+ * Return:       false if memory allocation failed
+ * @grid:        Output grid, should be freed by vl_grid_free
+ * @labels:      Input labels
+ * @label:       Input label of component, 0 takes all kept components
+ */
+_VL_EXTERN_ bool
+vl_grid_from_labels(
+	_VL_OUT_ VL_VoxelGrid * const    out_grid,
+	_VL_IN_  const VL_Labels * const in_labels,
+	_VL_IN_  const VL_Size           in_label
+	);
+
+
+/*
+ * Morphology of grid with structuring element of radius r
+ * Dilation grows the frame by r voxels on every side, other operations keep the frame of input,
+ * voxels out of frame are empty, so erosion also eats voxels within r of frame border
+ * Every pass shifts and ORs or ANDs whole 64 bit row words, in parallel over slices of z,
+ * box and cross cost O(log r) sweeps of the grid while sphere costs O(r^2) row operations per row
+ *
+ * Return:       false if memory allocation failed or frame grown by 2 * radius would not fit VL_Size
+ * @grid:        Output grid, should be freed by vl_grid_free
+ * @src:         Input grid
+ * @op:          Input operation
+ * @element:     Input structuring element
+ * @radius:      Input radius in voxels, 0 copies grid
+ */
+_VL_EXTERN_ bool
+vl_grid_morphology(
+	_VL_OUT_ VL_VoxelGrid * const       out_grid,
+	_VL_IN_  const VL_VoxelGrid * const in_src,
+	_VL_IN_  const VL_MorphOp           in_op,
+	_VL_IN_  const VL_MorphElement      in_element,
+	_VL_IN_  const VL_Size              in_radius
+	);
+
+
 #endif